@@ -97,7 +97,7 @@ int busca_binaria(int vetor[], int tamanho, int chave) {
 	while (min < max) {
 		med = (max+min)/2;
 		if (vetor[med] == chave) return med;
-		if (vetor[med] > chave) max = med - 1;
+		if (vetor[med] > chave) max = med; /* O espaço de busca é [min, max) */
 		else min = med + 1;
 	}
 	return -1;
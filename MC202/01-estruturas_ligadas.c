@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 /* Estruturas ligadas e listas ligadas simples
 
@@ -52,14 +53,142 @@ typedef struct nolista {
 	struct nolista *proximo;
 } NoLista;
 
+/* Cada chamada a malloc() tem um custo: o sistema precisa procurar um
+	 espaço livre, guardar informações de controle junto ao trecho alocado
+	 e, mais tarde, reorganizar esse espaço quando free() for chamada. Numa
+	 lista com dezenas de milhões de nós, esse custo passa a dominar o tempo
+	 de execução. Além disso, nós alocados um a um acabam espalhados pela
+	 memória, o que torna a varredura da lista mais lenta.
+
+	 Uma alternativa é o pool de nós: alocamos, de uma só vez, um bloco
+	 grande e contínuo com espaço para muitos nós, e entregamos os nós desse
+	 bloco um a um. Nós devolvidos não voltam para o sistema; eles são
+	 guardados numa lista de nós livres (que é, ela mesma, uma lista ligada
+	 usando o campo proximo!) e reaproveitados na próxima alocação. Assim,
+	 alocar e liberar um nó custa O(1) e não envolve o malloc(). Quando a
+	 lista inteira não é mais necessária, todos os blocos são devolvidos ao
+	 sistema de uma vez.
+*/
+#define NOS_POR_BLOCO 65536
+
+typedef struct blocopool {
+	struct blocopool *proximo; /* Blocos alocados formam uma lista ligada */
+	int capacidade; /* Quantos nós cabem neste bloco */
+	NoLista nos[]; /* Os nós ficam logo após o cabeçalho do bloco */
+} BlocoPool;
+
+typedef struct poolnos {
+	BlocoPool *blocos; /* Bloco atual (o último alocado) */
+	int usados; /* Quantos nós do bloco atual já foram entregues */
+	NoLista *livres; /* Nós devolvidos, prontos para reuso */
+} PoolNos;
+
+/* Neste programa, todas as funções de lista utilizam um mesmo pool. Um
+	 pool começa sem blocos, de forma que a primeira alocação já pede um novo
+	 bloco. Cada bloco é alocado com espaço para seu cabeçalho e para seus
+	 nós numa única chamada a malloc(): */
+PoolNos pool_nos = {NULL, 0, NULL};
+
+BlocoPool *novo_bloco(int capacidade) {
+	BlocoPool *bloco;
+	bloco = (BlocoPool *) malloc (sizeof(BlocoPool) + capacidade * sizeof(NoLista));
+	if (bloco == NULL) return NULL;
+	bloco->proximo = NULL;
+	bloco->capacidade = capacidade;
+	return bloco;
+}
+
+NoLista *aloca_no(PoolNos *pool) {
+	NoLista *no;
+	BlocoPool *bloco;
+
+	if (pool->livres != NULL) { /* Primeiro, reaproveita um nó devolvido */
+		no = pool->livres;
+		pool->livres = no->proximo;
+		return no;
+	}
+
+	if ((pool->blocos == NULL) || (pool->usados == pool->blocos->capacidade)) { /* Bloco atual esgotado */
+		bloco = novo_bloco(NOS_POR_BLOCO);
+		if (bloco == NULL) return NULL;
+		bloco->proximo = pool->blocos;
+		pool->blocos = bloco;
+		pool->usados = 0;
+	}
+
+	no = &(pool->blocos->nos[pool->usados]);
+	pool->usados = pool->usados + 1;
+	return no;
+}
+
+void libera_no(PoolNos *pool, NoLista *no) {
+	no->proximo = pool->livres;
+	pool->livres = no;
+}
+
+/* Também podemos pedir ao pool n nós contínuos de uma só vez. Se o bloco
+	 atual tiver espaço, os nós são retirados dele; caso contrário, um bloco
+	 do tamanho exato é alocado e colocado logo depois do bloco atual na lista
+	 de blocos, para que o espaço restante no bloco atual continue sendo
+	 usado por aloca_no(). Retorna NULL caso não haja memória disponível: */
+NoLista *aloca_nos_contiguos(PoolNos *pool, int n) {
+	NoLista *nos;
+	BlocoPool *bloco;
+
+	if ((pool->blocos != NULL) && (pool->usados + n <= pool->blocos->capacidade)) {
+		nos = &(pool->blocos->nos[pool->usados]);
+		pool->usados = pool->usados + n;
+		return nos;
+	}
+
+	bloco = novo_bloco(n);
+	if (bloco == NULL) return NULL;
+	if (pool->blocos == NULL) {
+		pool->blocos = bloco;
+		pool->usados = n;
+	} else {
+		bloco->proximo = pool->blocos->proximo;
+		pool->blocos->proximo = bloco;
+	}
+	return bloco->nos;
+}
+
+/* Uma lista inteira pode ser devolvida ao pool sem liberar nó a nó: basta
+	 encontrar seu último nó e ligá-lo ao começo da lista de nós livres. */
+void libera_lista_pool(PoolNos *pool, NoLista *inicio_lista) {
+	NoLista *ultimo;
+
+	if (inicio_lista == NULL) return;
+	ultimo = inicio_lista;
+	while (ultimo->proximo != NULL)
+		ultimo = ultimo->proximo;
+	ultimo->proximo = pool->livres;
+	pool->livres = inicio_lista;
+}
+
+/* Por fim, o pool inteiro (e, portanto, todas as listas construídas com
+	 ele) é devolvido ao sistema com uma chamada a free() por bloco: */
+void desaloca_pool(PoolNos *pool) {
+	BlocoPool *bloco;
+
+	while (pool->blocos != NULL) {
+		bloco = pool->blocos;
+		pool->blocos = bloco->proximo;
+		free(bloco);
+	}
+	pool->usados = 0;
+	pool->livres = NULL;
+}
+
 /* Tudo que o nosso sistema precisa guardar é um ponteiro para o começo da
 	 lista. Por convenção, o último nó da lista aponta para NULL, de forma que
-	 podemos varrer nossa lista toda. Podemos facilmente definir uma função que 
-	 cria um novo nó alocando a memória necessária, coloca o dado na posição
-	 correta e retorna um ponteiro para a memória alocada:
+	 podemos varrer nossa lista toda. Podemos facilmente definir uma função que
+	 cria um novo nó alocando a memória necessária (agora, a partir do pool),
+	 coloca o dado na posição correta e retorna um ponteiro para a memória
+	 alocada:
 */
 NoLista *novo_no(int dado) {
-	NoLista *no = (NoLista *) malloc (sizeof(NoLista));
+	NoLista *no = aloca_no(&pool_nos);
 	no->dado = dado;
 	no->proximo = NULL;
 	return no;
@@ -72,7 +201,7 @@ NoLista *novo_no(int dado) {
 NoLista *insere_comeco(NoLista *lista_atual, int dado) {
 	NoLista *novo_comeco;
 
-	novo_comeco = (NoLista*) malloc (sizeof (NoLista));
+	novo_comeco = aloca_no(&pool_nos);
 	novo_comeco->proximo = lista_atual;
 	novo_comeco->dado = dado;
 	return novo_comeco;
@@ -88,7 +217,7 @@ NoLista *remove_comeco(NoLista *lista_atual) {
 
 	if (lista_atual != NULL) {
 		novo_comeco = lista_atual->proximo;
-		free(lista_atual);
+		libera_no(&pool_nos, lista_atual);
 		return novo_comeco;
 	}
 	return NULL;
@@ -137,8 +266,46 @@ void insere_fim(NoLista *inicio_lista, int dado) {
 	insere_no(ponteiro_varredura, no_inserir);
 }
 
+/* Quando os dados de uma lista já estão num vetor, não é preciso
+	 inseri-los um a um: podemos pedir ao pool todos os nós de uma vez, em
+	 um trecho contínuo de memória, e ligar cada nó ao seguinte. O parâmetro
+	 invertida permite construir a lista na ordem inversa do vetor, que é
+	 a ordem obtida com inserções sucessivas no começo da lista: */
+NoLista *lista_de_vetor(int vetor[], int n, int invertida) {
+	/* Retorna NULL para n == 0 ou caso não haja memória disponível */
+	NoLista *nos;
+	int i;
+
+	if (n <= 0) return NULL;
+	nos = aloca_nos_contiguos(&pool_nos, n);
+	if (nos == NULL) return NULL;
+
+	for (i = 0; i < n; i++) {
+		if (invertida) nos[i].dado = vetor[n - 1 - i];
+		else nos[i].dado = vetor[i];
+		nos[i].proximo = &(nos[i + 1]);
+	}
+	nos[n - 1].proximo = NULL;
+	return nos;
+}
+
+/* E, no sentido contrário, podemos copiar os dados de uma lista para um
+	 vetor com até max posições. A função retorna quantos dados copiou: */
+int lista_para_vetor(NoLista *lista, int vetor[], int max) {
+	int n;
+
+	n = 0;
+	while ((lista != NULL) && (n < max)) {
+		vetor[n] = lista->dado;
+		n++;
+		lista = lista->proximo;
+	}
+	return n;
+}
+
 /* E, também utilizando a idéia de varredura, podemos criar uma
-	 função que desaloca toda a memória alocada pela lista. */
+	 função que desaloca toda a memória alocada pela lista (isto é,
+	 devolve todos os seus nós ao pool). */
 void desaloca_lista(NoLista *inicio_lista) {
 	NoLista *no_atual;
 	NoLista *no_anterior;
@@ -147,19 +314,25 @@ void desaloca_lista(NoLista *inicio_lista) {
 	while (no_atual != NULL) {
 		no_anterior = no_atual;
 		no_atual = no_atual->proximo;
-		free(no_anterior);
+		libera_no(&pool_nos, no_anterior);
 	}
 }
 
 /* É possível realizar a mesma operação utilizando uma função
 	 recursiva:
+	 void desaloca_lista_recursiva(NoLista *inicio_lista) {
+	   if (inicio_lista !=NULL) {
+	     desaloca_lista_recursiva(inicio_lista->proximo);
+	     free(inicio_lista);
+	   }
+	 }
+	 Porém, cada nó da lista acrescenta uma chamada à pilha de execução, e
+	 nenhuma delas termina antes de chegar ao fim da lista. Para listas de
+	 milhões de nós, isso causa um estouro de pilha (stack overflow), além
+	 do custo de cada chamada de função. Por isso, preferimos a versão
+	 iterativa acima - ou, com o pool, a devolução da lista inteira de uma
+	 vez com libera_lista_pool().
 */
-void desaloca_lista_recursiva(NoLista *inicio_lista) {
-	if (inicio_lista !=NULL) {
-		desaloca_lista_recursiva(inicio_lista->proximo);
-		free(inicio_lista);
-	}
-}
 
 /* Veja que nossa função de inserção só funciona de forma
 	 elegante se a lista atual não é vazia. Caso seja, é preciso primeiro
@@ -191,19 +364,97 @@ void desaloca_lista_recursiva(NoLista *inicio_lista) {
 	 - Representar uma fila FIFO, também de tamanho variável.
 */
 
+/* Para medir a diferença entre o pool e o malloc(), construímos a mesma
+	 lista das duas formas, varremos seus nós e então a desalocamos. */
+#define N_NOS_TESTE 10000000
+
+NoLista *constroi_lista_malloc(int n) {
+	NoLista *lista;
+	NoLista *no;
+	int i;
+
+	lista = NULL;
+	for (i=0; i<n; i++) {
+		no = (NoLista *) malloc (sizeof(NoLista));
+		no->dado = i;
+		no->proximo = lista;
+		lista = no;
+	}
+	return lista;
+}
+
+void desaloca_lista_malloc(NoLista *inicio_lista) {
+	NoLista *no_anterior;
+
+	while (inicio_lista != NULL) {
+		no_anterior = inicio_lista;
+		inicio_lista = inicio_lista->proximo;
+		free(no_anterior);
+	}
+}
+
+long long soma_lista(NoLista *lista) {
+	long long soma = 0;
+	while (lista != NULL) {
+		soma = soma + lista->dado;
+		lista = lista->proximo;
+	}
+	return soma;
+}
+
 /* Neste programa exemplo, demonstraremos como uma pila (FILO) funciona */
 int main() {
 	NoLista *pilha;
 	int valores[12] = {55, 23, 43, 2, 54, 12, 10, 2, 3, 4, 32, 100};
 	int i;
+	clock_t c1, c2; /* Contadores de relogio */
+	float tm, tp; /* Tempo gasto com malloc (tm) e com o pool (tp) */
+	long long soma;
+	int *vetor;
 
-	pilha = NULL;
-	for (i=0; i<12; i++)
-		pilha = insere_comeco(pilha, valores[i]);
+	/* O mesmo que inserir cada valor no começo da pilha, em ordem */
+	pilha = lista_de_vetor(valores, 12, 1);
 
 	imprime_lista(pilha);
+	i = lista_para_vetor(pilha, valores, 12);
+	printf("%d valores copiados de volta para o vetor\n", i);
 	desaloca_lista(pilha);
 
+	printf("---\nConstruindo, varrendo e desalocando %d nos\n", N_NOS_TESTE);
+	printf("Com malloc()... ");
+	c1 = clock();
+	pilha = constroi_lista_malloc(N_NOS_TESTE);
+	soma = soma_lista(pilha);
+	desaloca_lista_malloc(pilha);
+	c2 = clock();
+	tm = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("%f segundos (soma = %lld)\n", tm, soma);
+
+	printf("Com o pool de nos... ");
+	c1 = clock();
+	pilha = NULL;
+	for (i=0; i<N_NOS_TESTE; i++)
+		pilha = insere_comeco(pilha, i);
+	soma = soma_lista(pilha);
+	desaloca_pool(&pool_nos); /* Libera todos os blocos de uma só vez */
+	c2 = clock();
+	tp = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("%f segundos (soma = %lld)\n", tp, soma);
+
+	printf("O pool foi %f vezes mais rapido que o malloc()\n", tm/tp);
+
+	vetor = (int *) malloc(N_NOS_TESTE * sizeof(int));
+	for (i=0; i<N_NOS_TESTE; i++)
+		vetor[i] = i;
+	printf("Com lista_de_vetor()... ");
+	c1 = clock();
+	pilha = lista_de_vetor(vetor, N_NOS_TESTE, 1);
+	soma = soma_lista(pilha);
+	desaloca_pool(&pool_nos);
+	c2 = clock();
+	printf("%f segundos (soma = %lld)\n", (c2-c1)/(float)CLOCKS_PER_SEC, soma);
+	free(vetor);
+
 	return 0;
 }
 
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 /* Operações em listas ligadas
 
@@ -15,6 +16,111 @@ typedef struct nolista {
 	struct nolista *proximo;
 } NoLista;
 
+/* Como vimos na aula anterior, nossos nós não são alocados diretamente com
+	 malloc(), e sim a partir de um pool: blocos grandes e contínuos de nós,
+	 com uma lista de nós livres para reaproveitar nós devolvidos. Todas as
+	 operações desta aula utilizam o mesmo pool:
+*/
+#define NOS_POR_BLOCO 65536
+
+typedef struct blocopool {
+	struct blocopool *proximo;
+	int capacidade; /* Quantos nós cabem neste bloco */
+	NoLista nos[]; /* Os nós ficam logo após o cabeçalho do bloco */
+} BlocoPool;
+
+typedef struct poolnos {
+	BlocoPool *blocos; /* Bloco atual (o último alocado) */
+	int usados; /* Quantos nós do bloco atual já foram entregues */
+	NoLista *livres; /* Nós devolvidos, prontos para reuso */
+} PoolNos;
+
+PoolNos pool_nos = {NULL, 0, NULL};
+
+BlocoPool *novo_bloco(int capacidade) {
+	BlocoPool *bloco;
+	bloco = (BlocoPool *) malloc (sizeof(BlocoPool) + capacidade * sizeof(NoLista));
+	if (bloco == NULL) return NULL;
+	bloco->proximo = NULL;
+	bloco->capacidade = capacidade;
+	return bloco;
+}
+
+NoLista *aloca_no(PoolNos *pool) {
+	/* Retorna NULL caso não haja memória disponível, assim como malloc() */
+	NoLista *no;
+	BlocoPool *bloco;
+
+	if (pool->livres != NULL) {
+		no = pool->livres;
+		pool->livres = no->proximo;
+		return no;
+	}
+
+	if ((pool->blocos == NULL) || (pool->usados == pool->blocos->capacidade)) {
+		bloco = novo_bloco(NOS_POR_BLOCO);
+		if (bloco == NULL) return NULL;
+		bloco->proximo = pool->blocos;
+		pool->blocos = bloco;
+		pool->usados = 0;
+	}
+
+	no = &(pool->blocos->nos[pool->usados]);
+	pool->usados = pool->usados + 1;
+	return no;
+}
+
+void libera_no(PoolNos *pool, NoLista *no) {
+	no->proximo = pool->livres;
+	pool->livres = no;
+}
+
+NoLista *aloca_nos_contiguos(PoolNos *pool, int n) {
+	/* Retorna n nós contínuos, ou NULL caso não haja memória disponível */
+	NoLista *nos;
+	BlocoPool *bloco;
+
+	if ((pool->blocos != NULL) && (pool->usados + n <= pool->blocos->capacidade)) {
+		nos = &(pool->blocos->nos[pool->usados]);
+		pool->usados = pool->usados + n;
+		return nos;
+	}
+
+	bloco = novo_bloco(n);
+	if (bloco == NULL) return NULL;
+	if (pool->blocos == NULL) {
+		pool->blocos = bloco;
+		pool->usados = n;
+	} else {
+		bloco->proximo = pool->blocos->proximo;
+		pool->blocos->proximo = bloco;
+	}
+	return bloco->nos;
+}
+
+void libera_lista_pool(PoolNos *pool, NoLista *inicio_lista) {
+	NoLista *ultimo;
+
+	if (inicio_lista == NULL) return;
+	ultimo = inicio_lista;
+	while (ultimo->proximo != NULL)
+		ultimo = ultimo->proximo;
+	ultimo->proximo = pool->livres;
+	pool->livres = inicio_lista;
+}
+
+void desaloca_pool(PoolNos *pool) {
+	BlocoPool *bloco;
+
+	while (pool->blocos != NULL) {
+		bloco = pool->blocos;
+		pool->blocos = bloco->proximo;
+		free(bloco);
+	}
+	pool->usados = 0;
+	pool->livres = NULL;
+}
+
 /* Como vimos anteriormente, podemos criar uma função que adiciona
 	 um nó a uma lista, sendo que uma lista vazia é representada por um
 	 ponteiro para NULL. Para manter nossa funcionalidade simples,
@@ -27,8 +133,8 @@ int adiciona_final(NoLista **lista, int dado) {
 	NoLista *ponteiro;
 	
 	if ((*lista) == NULL) { /* Adicionar nó em uma lista vazia */
-		(*lista) = (NoLista*) malloc (sizeof(NoLista));
-			if ((*lista) != NULL ) { /* malloc() retorna NULL caso não haja
+		(*lista) = aloca_no(&pool_nos);
+			if ((*lista) != NULL ) { /* aloca_no() retorna NULL caso não haja
 																	memória disponível */
 			(*lista)->proximo = NULL;
 			(*lista)->dado = dado;
@@ -42,7 +148,7 @@ int adiciona_final(NoLista **lista, int dado) {
 
 		while (ponteiro->proximo != NULL) /* Varre lista até o fim */
 			ponteiro = ponteiro->proximo;
-		ponteiro->proximo = (NoLista*) malloc (sizeof(NoLista));
+		ponteiro->proximo = aloca_no(&pool_nos);
 		if (ponteiro->proximo != NULL) {
 			ponteiro->proximo->dado = dado;
 			ponteiro->proximo->proximo = NULL;
@@ -61,13 +167,22 @@ int adiciona_final(NoLista **lista, int dado) {
 	 toda a memória já alocada para a construção da lista. Adicionalmente,
 	 essa função tornará nosso ponteiro para o nó inicial um ponteiro para
 	 lista vazia, o que garante a consistência de nossa representação.
-	 Vamos adotar, por simplicidade, nossa implementação recursiva:
+
+	 Uma implementação recursiva seria:
+	 void deleta_lista(NoLista **lista) {
+	   if ( (*lista)->proximo != NULL )
+	     deleta_lista (&((*lista)->proximo));
+	   free(*lista);
+	   (*lista) = NULL;
+	 }
+	 Porém, essa função faz uma chamada recursiva por nó, e só libera o
+	 primeiro nó depois que todos os outros forem liberados. Para uma lista
+	 de milhões de elementos, a pilha de execução se esgota (stack overflow)
+	 antes disso. Como nossos nós vêm do pool, podemos devolver a lista
+	 inteira de uma só vez, com uma única varredura iterativa:
 */
 void deleta_lista(NoLista **lista) {
-	if ( (*lista)->proximo != NULL ) /* Se a lista a seguir não é adiante */
-		deleta_lista (&((*lista)->proximo)); /* desaloca a lista que começa no
-																						próximo nó */
-	free(*lista); /* Desaloca o nó atual */
+	libera_lista_pool(&pool_nos, *lista);
 	(*lista) = NULL; /* A lista atual passa a ser nula */
 }
 
@@ -133,38 +248,498 @@ void inverte_lista(NoLista **lista) {
 	(*lista) = anterior;
 }
 
+/* Quando os dados de uma lista já estão num vetor, podemos construir a
+	 lista inteira de uma só vez: pedimos ao pool n nós contínuos e ligamos
+	 cada nó ao seguinte. Os nós ficam na memória na mesma ordem em que
+	 aparecem na lista, o que torna sua varredura tão rápida quanto possível.
+	 O parâmetro invertida permite construir a lista na ordem inversa do
+	 vetor (como faria uma sequência de inserções no começo da lista): */
+NoLista *lista_de_vetor(int vetor[], int n, int invertida) {
+	/* Retorna NULL para n == 0 ou caso não haja memória disponível */
+	NoLista *nos;
+	int i;
+
+	if (n <= 0) return NULL;
+	nos = aloca_nos_contiguos(&pool_nos, n);
+	if (nos == NULL) return NULL;
+
+	for (i = 0; i < n; i++) {
+		if (invertida) nos[i].dado = vetor[n - 1 - i];
+		else nos[i].dado = vetor[i];
+		nos[i].proximo = &(nos[i + 1]);
+	}
+	nos[n - 1].proximo = NULL;
+	return nos;
+}
+
+/* A operação inversa copia os dados da lista para um vetor, até o máximo
+	 de posições do vetor, e retorna quantos dados foram copiados: */
+int lista_para_vetor(NoLista *lista, int vetor[], int max) {
+	int n;
+
+	n = 0;
+	while ((lista != NULL) && (n < max)) {
+		vetor[n] = lista->dado;
+		n++;
+		lista = lista->proximo;
+	}
+	return n;
+}
+
 /* Por fim, é possível que queiramos copiar os elementos de uma lista
 	 explicitamente. A isso, se dá o nome de cópia profunda: um novo
 	 espaço de memória é alocado, contendo cópias do espaço original. Isso
-	 é diferente de criar um novo ponteiro para o mesmo espaço de memória. */
-NoLista *copia_profunda(NoLista **origem) {
+	 é diferente de criar um novo ponteiro para o mesmo espaço de memória.
+
+	 Assim como em lista_de_vetor(), contamos os nós da lista de origem e
+	 pedimos ao pool todos os nós da cópia de uma só vez. A cópia dos n
+	 primeiros nós fica numa função separada, para que quem já sabe o
+	 tamanho da lista não precise contá-la de novo: */
+NoLista *copia_nos(NoLista *origem, int n) {
 	NoLista *nova_lista;
-	NoLista *ponteiro_dest;
 	NoLista *ponteiro_origem;
+	int i;
 
-	if ((*origem) == NULL) return NULL; /* Caso especial para lista vazia */
+	if (n == 0) return NULL; /* Caso especial para lista vazia */
 
-	nova_lista = (NoLista*) malloc(sizeof(NoLista));
-	
-	ponteiro_dest = nova_lista;
-	ponteiro_origem = (*origem);
+	nova_lista = aloca_nos_contiguos(&pool_nos, n);
+	if (nova_lista == NULL) return NULL;
 
-	ponteiro_dest->dado = ponteiro_origem->dado;
-  while (ponteiro_origem->proximo != NULL) {
+	ponteiro_origem = origem;
+	for (i = 0; i < n; i++) {
+		nova_lista[i].dado = ponteiro_origem->dado;
+		nova_lista[i].proximo = &(nova_lista[i + 1]);
 		ponteiro_origem = ponteiro_origem->proximo;
-		ponteiro_dest->proximo = (NoLista*) malloc (sizeof(NoLista));
-		ponteiro_dest = ponteiro_dest->proximo;
-		ponteiro_dest->dado = ponteiro_origem->dado;
 	}
-	ponteiro_dest->proximo = NULL;
+	nova_lista[n - 1].proximo = NULL;
 	return nova_lista;
 }
 
+NoLista *copia_profunda(NoLista **origem) {
+	NoLista *ponteiro_origem;
+	int n;
+
+	n = 0;
+	for (ponteiro_origem = (*origem); ponteiro_origem != NULL;
+			 ponteiro_origem = ponteiro_origem->proximo)
+		n++;
+	return copia_nos(*origem, n);
+}
+
+/* Repare que adiciona_final() e concatena_listas() precisam varrer a lista
+	 inteira até o último nó a cada chamada. Assim, construir uma lista de N
+	 elementos chamando adiciona_final() N vezes custa 1 + 2 + ... + N passos,
+	 ou seja, O(N^2). Para evitar essa varredura, podemos guardar, junto ao
+	 ponteiro para o começo da lista, um ponteiro para seu último nó e o
+	 número de elementos. Essa estrutura é um descritor (handle) da lista:
+*/
+typedef struct lista {
+	int n_elementos;
+	NoLista *inicio;
+	NoLista *final;
+} Lista;
+
+Lista *nova_lista() {
+	Lista *novo;
+	novo = (Lista*) malloc(sizeof(Lista));
+	novo->n_elementos = 0;
+	novo->inicio = NULL;
+	novo->final = NULL;
+	return novo;
+}
+
+/* Com o ponteiro para o final, adicionar um elemento custa O(1): */
+int lista_adiciona_final(Lista *l, int dado) {
+	/* Retorna 1 caso a adição tenha sido realizada com sucesso,
+		 e 0 em caso de erro */
+	NoLista *novo_no;
+
+	novo_no = aloca_no(&pool_nos);
+	if (novo_no == NULL) return 0;
+	novo_no->dado = dado;
+	novo_no->proximo = NULL;
+
+	if (l->n_elementos == 0)
+		l->inicio = novo_no;
+	else
+		l->final->proximo = novo_no;
+	l->final = novo_no;
+	l->n_elementos = l->n_elementos + 1;
+	return 1;
+}
+
+int lista_tamanho(Lista *l) {
+	return l->n_elementos;
+}
+
+/* A concatenação também passa a custar O(1). Para evitar o problema de
+	 dois descritores apontarem para os mesmos nós, os nós da segunda lista
+	 passam a pertencer à primeira e a segunda lista fica vazia: */
+void lista_concatena(Lista *l_inicio, Lista *l_fim) {
+	if (l_fim->n_elementos == 0) return;
+
+	if (l_inicio->n_elementos == 0)
+		l_inicio->inicio = l_fim->inicio;
+	else
+		l_inicio->final->proximo = l_fim->inicio;
+	l_inicio->final = l_fim->final;
+	l_inicio->n_elementos = l_inicio->n_elementos + l_fim->n_elementos;
+
+	l_fim->inicio = NULL;
+	l_fim->final = NULL;
+	l_fim->n_elementos = 0;
+}
+
+/* As demais operações reaproveitam as funções sobre NoLista, tomando o
+	 cuidado de manter o ponteiro para o final atualizado: */
+void lista_inverte(Lista *l) {
+	l->final = l->inicio; /* O primeiro nó passará a ser o último */
+	inverte_lista(&(l->inicio));
+}
+
+void lista_imprime(Lista *l) {
+	imprime_lista(&(l->inicio));
+}
+
+/* Retorna NULL caso não haja memória para a cópia */
+Lista *lista_copia_profunda(Lista *origem) {
+	Lista *copia;
+
+	copia = nova_lista();
+	if (origem->n_elementos == 0) return copia;
+	copia->inicio = copia_nos(origem->inicio, origem->n_elementos);
+	if (copia->inicio == NULL) {
+		free(copia);
+		return NULL;
+	}
+	copia->n_elementos = origem->n_elementos;
+	/* Os nós da cópia são contínuos, então o último é conhecido: */
+	copia->final = &(copia->inicio[copia->n_elementos - 1]);
+	return copia;
+}
+
+/* Para desalocar a lista, devolvemos todos os seus nós ao pool de uma vez
+	 (o último nó é conhecido, então não é preciso varrer a lista) e então
+	 desalocamos o descritor: */
+void lista_deleta(Lista *l) {
+	if (l->n_elementos > 0) {
+		l->final->proximo = pool_nos.livres;
+		pool_nos.livres = l->inicio;
+	}
+	free(l);
+}
+
+/* Para ordenar uma lista ligada, o algoritmo mais adequado é a ordenação
+	 por intercalação (merge sort). Intercalar duas listas já ordenadas é
+	 simples: a cada passo, retiramos o menor dos dois primeiros nós e o
+	 ligamos ao final do resultado. Nenhum nó é copiado e nenhuma memória é
+	 alocada - apenas os ponteiros proximo são modificados. Usamos um nó
+	 cabeça temporário (na pilha, e não alocado) para não tratar de forma
+	 especial o primeiro nó do resultado.
+
+	 Em caso de empate, o nó da primeira lista vem antes. Assim, elementos
+	 iguais mantêm sua ordem original, ou seja, a ordenação é estável: */
+NoLista *intercala_ordenadas(NoLista *a, NoLista *b) {
+	NoLista cabeca;
+	NoLista *fim;
+
+	fim = &cabeca;
+	while ((a != NULL) && (b != NULL)) {
+		if (b->dado < a->dado) {
+			fim->proximo = b;
+			b = b->proximo;
+		} else {
+			fim->proximo = a;
+			a = a->proximo;
+		}
+		fim = fim->proximo;
+	}
+	if (a != NULL) fim->proximo = a;
+	else fim->proximo = b;
+	return cabeca.proximo;
+}
+
+/* A versão recursiva do merge sort divide a lista ao meio, o que exige
+	 varrê-la para encontrar o meio e faz chamadas recursivas. Podemos, em vez
+	 disso, construir a ordenação de baixo para cima (bottom-up), como um
+	 contador binário: niveis[i] guarda uma lista ordenada de 2^i nós (ou
+	 está vazio). Cada nó retirado da entrada forma uma lista de tamanho 1,
+	 que é intercalada com niveis[0], niveis[1], ... enquanto esses níveis
+	 estiverem ocupados - exatamente como o "vai um" de uma soma binária.
+	 Como 64 níveis são suficientes para 2^64 nós, a memória extra é
+	 constante, e o algoritmo tem complexidade O(N log N).
+
+	 Os níveis mais altos sempre contêm nós que vieram antes na lista
+	 original, então eles são sempre o primeiro argumento da intercalação,
+	 o que preserva a estabilidade: */
+#define MAX_NIVEIS 64
+
+void ordena_lista(NoLista **lista) {
+	NoLista *niveis[MAX_NIVEIS];
+	NoLista *atual;
+	NoLista *corrida;
+	int i;
+
+	for (i = 0; i < MAX_NIVEIS; i++)
+		niveis[i] = NULL;
+
+	atual = (*lista);
+	while (atual != NULL) {
+		corrida = atual;
+		atual = atual->proximo;
+		corrida->proximo = NULL;
+
+		for (i = 0; (i < MAX_NIVEIS - 1) && (niveis[i] != NULL); i++) {
+			corrida = intercala_ordenadas(niveis[i], corrida);
+			niveis[i] = NULL;
+		}
+		niveis[i] = intercala_ordenadas(niveis[i], corrida);
+	}
+
+	corrida = NULL;
+	for (i = 0; i < MAX_NIVEIS; i++)
+		corrida = intercala_ordenadas(niveis[i], corrida);
+	(*lista) = corrida;
+}
+
+/* A ordenação muda o último nó da lista, então a versão para o descritor
+	 precisa percorrer a lista ordenada para reencontrá-lo. Isso custa O(N),
+	 bem menos que os O(N log N) da própria ordenação: */
+void lista_ordena(Lista *l) {
+	NoLista *atual;
+
+	ordena_lista(&(l->inicio));
+	l->final = NULL;
+	for (atual = l->inicio; atual != NULL; atual = atual->proximo)
+		l->final = atual;
+}
+
+/* A mesma ideia permite intercalar k listas já ordenadas. Intercalamos as
+	 listas duas a duas (0 com 1, 2 com 3, ...), depois os resultados duas
+	 a duas, e assim por diante. Cada nó participa de log2(k) intercalações,
+	 de forma que o custo total é O(N log k). Como sempre intercalamos listas
+	 vizinhas, com a de menor índice primeiro, a intercalação também é
+	 estável. O vetor listas[] é usado como espaço de trabalho: */
+NoLista *intercala_k_listas(NoLista *listas[], int k) {
+	int passo;
+	int i;
+
+	if (k == 0) return NULL;
+	for (passo = 1; passo < k; passo = passo * 2)
+		for (i = 0; i + passo < k; i = i + 2 * passo) {
+			listas[i] = intercala_ordenadas(listas[i], listas[i + passo]);
+			listas[i + passo] = NULL;
+		}
+	return listas[0];
+}
+
+/* Para comparar, ordenamos os mesmos dados copiando-os para um vetor e
+	 usando o quick sort (com o nó inicial como pivô, como em MC102). A
+	 recursão é feita somente na parte menor do vetor, o que limita a
+	 profundidade da pilha a O(log N): */
+void troca(int *a, int *b) {
+	int c;
+	c = *a;
+	*a = *b;
+	*b = c;
+}
+
+void quick_sort(int vetor[], int N) {
+	int pivot;
+	int i;
+	int j;
+
+	while (N > 1) {
+		pivot = vetor[0];
+		j = 0;
+		for (i = 1; i < N; i++)
+			if (vetor[i] < pivot) {
+				j++;
+				troca(&(vetor[i]), &(vetor[j]));
+			}
+		troca(&(vetor[0]), &(vetor[j]));
+
+		if (j < N - j - 1) {
+			quick_sort(vetor, j);
+			vetor = &(vetor[j + 1]);
+			N = N - j - 1;
+		} else {
+			quick_sort(&(vetor[j + 1]), N - j - 1);
+			N = j;
+		}
+	}
+}
+
+void ordena_lista_vetor(Lista *l) {
+	int *vetor;
+	NoLista *ponteiro;
+	int i;
+
+	vetor = (int *) malloc(l->n_elementos * sizeof(int));
+	lista_para_vetor(l->inicio, vetor, l->n_elementos);
+	quick_sort(vetor, l->n_elementos);
+	for (ponteiro = l->inicio, i = 0; ponteiro != NULL; ponteiro = ponteiro->proximo, i++)
+		ponteiro->dado = vetor[i];
+	free(vetor);
+}
+
+int esta_ordenada(NoLista *lista) {
+	/* Retorna 1 se a lista está em ordem crescente e 0 caso contrário */
+	if (lista == NULL) return 1;
+	while (lista->proximo != NULL) {
+		if (lista->proximo->dado < lista->dado) return 0;
+		lista = lista->proximo;
+	}
+	return 1;
+}
+
+#define N_ORDENACAO 10000000
+#define K_LISTAS 16
+
+void teste_ordenacao() {
+	Lista *l;
+	NoLista *listas[K_LISTAS];
+	NoLista *resultado;
+	int i;
+	clock_t c1, c2;
+	float tm, tq;
+
+	printf("Ordenando %d nos\n", N_ORDENACAO);
+	srand(1);
+	l = nova_lista();
+	for (i = 0; i < N_ORDENACAO; i++)
+		lista_adiciona_final(l, rand());
+	c1 = clock();
+	lista_ordena(l);
+	c2 = clock();
+	tm = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("merge sort na lista: %f segundos (ordenada: %d)\n", tm,
+				 esta_ordenada(l->inicio));
+	lista_deleta(l);
+
+	srand(1);
+	l = nova_lista();
+	for (i = 0; i < N_ORDENACAO; i++)
+		lista_adiciona_final(l, rand());
+	c1 = clock();
+	ordena_lista_vetor(l);
+	c2 = clock();
+	tq = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("copia para vetor + quick sort: %f segundos (ordenada: %d)\n", tq,
+				 esta_ordenada(l->inicio));
+	lista_deleta(l);
+
+	/* Intercalação de K_LISTAS listas ordenadas */
+	for (i = 0; i < K_LISTAS; i++) {
+		listas[i] = NULL;
+		l = nova_lista();
+		while (l->n_elementos < N_ORDENACAO / K_LISTAS)
+			lista_adiciona_final(l, rand());
+		lista_ordena(l);
+		/* Os nós passam para listas[i]; só o descritor é desalocado */
+		listas[i] = l->inicio;
+		free(l);
+	}
+	c1 = clock();
+	resultado = intercala_k_listas(listas, K_LISTAS);
+	c2 = clock();
+	printf("intercalacao de %d listas: %f segundos (ordenada: %d)\n", K_LISTAS,
+				 (c2-c1)/(float)CLOCKS_PER_SEC, esta_ordenada(resultado));
+	deleta_lista(&resultado);
+}
+
+/* Como nenhuma das operações acima é recursiva, podemos trabalhar com
+	 listas muito longas sem estourar a pilha de execução. O teste abaixo
+	 constrói, copia e desaloca listas de N_ESTRESSE nós (cerca de 1,6 GB
+	 de memória para 10^8 nós). Em máquinas com menos memória, compile com
+	 -DN_ESTRESSE=10000000, por exemplo. */
+#ifndef N_ESTRESSE
+#define N_ESTRESSE 100000000
+#endif
+
+void teste_estresse() {
+	Lista *l;
+	NoLista *copia;
+	int i;
+	clock_t c1, c2;
+	float t;
+
+	/* Começamos com o pool vazio: nós devolvidos por testes anteriores
+		 estariam espalhados pela memória e mascarariam o custo por nó */
+	desaloca_pool(&pool_nos);
+
+	printf("Teste de estresse com %d nos\n", N_ESTRESSE);
+	l = nova_lista();
+	for (i = 0; i < N_ESTRESSE; i++)
+		lista_adiciona_final(l, i);
+	c1 = clock();
+	deleta_lista(&(l->inicio));
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("deleta_lista: %f segundos (%f ns por no)\n", t, 1e9*t/N_ESTRESSE);
+	free(l);
+
+	/* Os nós devolvidos são reaproveitados pelo pool: a lista e sua cópia,
+		 juntas, ocupam os mesmos N_ESTRESSE nós */
+	l = nova_lista();
+	for (i = 0; i < N_ESTRESSE/2; i++)
+		lista_adiciona_final(l, i);
+	c1 = clock();
+	copia = copia_profunda(&(l->inicio));
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("copia_profunda: %f segundos (%f ns por no)\n", t, 1e9*t/(N_ESTRESSE/2));
+	deleta_lista(&copia);
+	lista_deleta(l);
+}
+
+/* Para medir a diferença, construímos listas de tamanhos entre 10^3 e
+	 10^7 elementos usando o descritor, e comparamos com adiciona_final()
+	 enquanto o custo quadrático ainda permite esperar pelo resultado: */
+#define MAX_TESTE_QUADRATICO 10000
+
+void teste_adiciona_final() {
+	int n;
+	int i;
+	clock_t c1, c2;
+	float t;
+	Lista *l;
+	NoLista *lista;
+
+	printf("N\tdescritor (elem/s)\tadiciona_final (elem/s)\n");
+	for (n = 1000; n <= 10000000; n = n * 10) {
+		c1 = clock();
+		l = nova_lista();
+		for (i = 0; i < n; i++)
+			lista_adiciona_final(l, i);
+		c2 = clock();
+		t = (c2-c1)/(float)CLOCKS_PER_SEC;
+		printf("%d\t%e", n, n/t);
+		lista_deleta(l);
+
+		if (n <= MAX_TESTE_QUADRATICO) {
+			lista = NULL;
+			c1 = clock();
+			for (i = 0; i < n; i++)
+				adiciona_final(&lista, i);
+			c2 = clock();
+			t = (c2-c1)/(float)CLOCKS_PER_SEC;
+			printf("\t\t%e\n", n/t);
+			deleta_lista(&lista);
+		} else {
+			printf("\t\t-\n");
+		}
+	}
+}
+
 int main() {
 	int i;
 	NoLista *lista1;
 	NoLista *lista2;
 	NoLista *lista3;
+	Lista *l1;
+	Lista *l2;
+	Lista *l3;
 
 	lista1 = NULL;
 	lista2 = NULL;
@@ -206,6 +781,31 @@ int main() {
 	deleta_lista(&lista1);
 	deleta_lista(&lista3);
 
+	printf("Construindo listas com o descritor\n");
+	l1 = nova_lista();
+	l2 = nova_lista();
+	for (i = 0; i < 5; i++) {
+		lista_adiciona_final(l1, i);
+		lista_adiciona_final(l2, i+10);
+	}
+	lista_concatena(l1, l2);
+	lista_inverte(l1);
+	l3 = lista_copia_profunda(l1);
+	lista_adiciona_final(l3, 100);
+	printf("Lista 1 (%d elementos)\n", lista_tamanho(l1));
+	lista_imprime(l1);
+	printf("Lista 2 (%d elementos)\n", lista_tamanho(l2));
+	lista_imprime(l2);
+	printf("Lista 3 (%d elementos)\n", lista_tamanho(l3));
+	lista_imprime(l3);
+	lista_deleta(l1);
+	lista_deleta(l2);
+	lista_deleta(l3);
+
+	teste_adiciona_final();
+	teste_ordenacao();
+	teste_estresse();
+	desaloca_pool(&pool_nos);
 
 
 	return 0;
@@ -25,6 +25,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 typedef struct nolista {
 	int dado;
@@ -37,18 +39,167 @@ typedef struct lista {
 	NoLista *final;
 } Lista;
 
+/* Contabilidade de memória
+
+	 Para saber quanta memória as pilhas e filas de um programa usam,
+	 mantemos alguns contadores, atualizados pelas funções abaixo e que podem
+	 ser lidos a qualquer momento:
+
+	 - bytes_alocados: memória obtida com malloc() e ainda não liberada
+	   (cabeçalhos de listas e blocos de nós, e as pilhas e filas em vetor
+	   mais abaixo);
+	 - n_alocacoes: número de chamadas a malloc() e realloc();
+	 - nos_em_uso e pico_nos_em_uso: número de elementos guardados em todas
+	   as listas, agora e no máximo já atingido;
+	 - n_operacoes: número de inserções e remoções nas listas. As estruturas
+	   em vetor não contam suas operações: lá, atualizar os contadores
+	   custaria mais que a própria operação.
+
+	 Dividindo n_alocacoes por n_operacoes, temos o número de alocações por
+	 operação. Com um malloc() por nó, esse número seria próximo de 0,5 (uma
+	 alocação a cada par inserção/remoção); com o pool abaixo, ele tende a
+	 zero. */
+typedef struct estatisticasmemoria {
+	long long bytes_alocados;
+	long long n_alocacoes;
+	long long nos_em_uso;
+	long long pico_nos_em_uso;
+	long long n_operacoes;
+} EstatisticasMemoria;
+
+EstatisticasMemoria estatisticas = {0, 0, 0, 0, 0};
+
+void *aloca_contabilizado(size_t bytes) {
+	void *p = malloc(bytes);
+	if (p != NULL) {
+		estatisticas.bytes_alocados = estatisticas.bytes_alocados + bytes;
+		estatisticas.n_alocacoes = estatisticas.n_alocacoes + 1;
+	}
+	return p;
+}
+
+void libera_contabilizado(void *p, size_t bytes) {
+	free(p);
+	estatisticas.bytes_alocados = estatisticas.bytes_alocados - bytes;
+}
+
+void *realoca_contabilizado(void *p, size_t bytes_antigos, size_t bytes) {
+	void *novo = realloc(p, bytes);
+	if (novo != NULL) {
+		estatisticas.bytes_alocados = estatisticas.bytes_alocados - bytes_antigos + bytes;
+		estatisticas.n_alocacoes = estatisticas.n_alocacoes + 1;
+	}
+	return novo;
+}
+
+double alocacoes_por_operacao() {
+	if (estatisticas.n_operacoes == 0) return 0;
+	return estatisticas.n_alocacoes / (double) estatisticas.n_operacoes;
+}
+
+void imprime_estatisticas() {
+	printf("Bytes alocados: %lld\n", estatisticas.bytes_alocados);
+	printf("Chamadas a malloc(): %lld\n", estatisticas.n_alocacoes);
+	printf("Elementos guardados: %lld (pico: %lld)\n", estatisticas.nos_em_uso,
+				 estatisticas.pico_nos_em_uso);
+	printf("Operacoes: %lld (%g alocacoes por operacao)\n",
+				 estatisticas.n_operacoes, alocacoes_por_operacao());
+}
+
+/* Pool de nós
+
+	 Como nas aulas sobre estruturas ligadas, os nós são entregues por um
+	 pool: alocamos blocos com NOS_POR_BLOCO nós de uma vez, e os nós
+	 removidos vão para uma lista de nós livres, de onde são reaproveitados.
+	 Depois que a pilha ou fila atinge seu tamanho máximo, nenhuma inserção
+	 chama malloc(). */
+#define NOS_POR_BLOCO 4096
+
+typedef struct blocopool {
+	struct blocopool *proximo;
+	int capacidade; /* Quantos nós cabem neste bloco */
+	NoLista nos[]; /* Os nós ficam logo após o cabeçalho do bloco */
+} BlocoPool;
+
+typedef struct poolnos {
+	BlocoPool *blocos; /* Bloco atual (o último alocado) */
+	int usados; /* Quantos nós do bloco atual já foram entregues */
+	NoLista *livres; /* Nós devolvidos, prontos para reuso */
+} PoolNos;
+
+PoolNos pool_nos = {NULL, 0, NULL};
+
+NoLista *aloca_no(PoolNos *pool) {
+	/* Retorna NULL caso não haja memória disponível, assim como malloc() */
+	NoLista *no;
+	BlocoPool *bloco;
+
+	if (pool->livres != NULL) {
+		no = pool->livres;
+		pool->livres = no->proximo;
+		return no;
+	}
+
+	if ((pool->blocos == NULL) || (pool->usados == pool->blocos->capacidade)) {
+		bloco = (BlocoPool *) aloca_contabilizado(sizeof(BlocoPool) +
+																							NOS_POR_BLOCO * sizeof(NoLista));
+		if (bloco == NULL) return NULL;
+		bloco->capacidade = NOS_POR_BLOCO;
+		bloco->proximo = pool->blocos;
+		pool->blocos = bloco;
+		pool->usados = 0;
+	}
+
+	no = &(pool->blocos->nos[pool->usados]);
+	pool->usados = pool->usados + 1;
+	return no;
+}
+
+void libera_no(PoolNos *pool, NoLista *no) {
+	no->proximo = pool->livres;
+	pool->livres = no;
+}
+
+void desaloca_pool(PoolNos *pool) {
+	BlocoPool *bloco;
+
+	while (pool->blocos != NULL) {
+		bloco = pool->blocos;
+		pool->blocos = bloco->proximo;
+		libera_contabilizado(bloco, sizeof(BlocoPool) +
+												 bloco->capacidade * sizeof(NoLista));
+	}
+	pool->usados = 0;
+	pool->livres = NULL;
+}
+
+void conta_insercao() {
+	estatisticas.n_operacoes = estatisticas.n_operacoes + 1;
+	estatisticas.nos_em_uso = estatisticas.nos_em_uso + 1;
+	if (estatisticas.nos_em_uso > estatisticas.pico_nos_em_uso)
+		estatisticas.pico_nos_em_uso = estatisticas.nos_em_uso;
+}
+
+void conta_remocao() {
+	estatisticas.n_operacoes = estatisticas.n_operacoes + 1;
+	estatisticas.nos_em_uso = estatisticas.nos_em_uso - 1;
+}
+
 Lista *nova_lista() {
 	Lista *novo;
-	novo = (Lista*) malloc(sizeof(Lista));
+	novo = (Lista*) aloca_contabilizado(sizeof(Lista));
 	novo->n_elementos = 0;
 	novo->inicio = 0;
 	novo->final = 0;
 	return novo;
 }
 
+/* Cada nó ocupa sizeof(NoLista) bytes. (Uma versão anterior destas funções
+	 alocava sizeof(Lista), o tamanho do cabeçalho da lista, que é maior, e
+	 desperdiçava memória em cada inserção.) */
 void insere_comeco(Lista *minha_lista, int dado) {
 	NoLista *novo_no;
-	novo_no = (NoLista*) malloc(sizeof(Lista));
+	novo_no = aloca_no(&pool_nos);
 	novo_no->proximo = minha_lista->inicio;
 	novo_no->dado = dado;
 	minha_lista->inicio = novo_no;
@@ -59,11 +210,12 @@ void insere_comeco(Lista *minha_lista, int dado) {
 	}
 
 	minha_lista->n_elementos = (minha_lista->n_elementos) + 1;
+	conta_insercao();
 }
 
 void insere_final(Lista *minha_lista, int dado) {
 	NoLista *novo_no;
-	novo_no = (NoLista*) malloc(sizeof(Lista));
+	novo_no = aloca_no(&pool_nos);
 	novo_no->proximo = NULL;
 	novo_no->dado = dado;
 
@@ -76,31 +228,192 @@ void insere_final(Lista *minha_lista, int dado) {
 	}
 
 	minha_lista->n_elementos = (minha_lista->n_elementos) + 1;
+	conta_insercao();
 }
 
-int remove_comeco(Lista *minha_lista) {
-	int dado;
-	NoLista *proximo;
+/* Retira o primeiro elemento da lista e o escreve em *dado. Retorna 1 em
+	 caso de sucesso e 0 se a lista está vazia. Como o resultado da operação
+	 não se mistura com o dado, qualquer valor (inclusive -1) pode ser
+	 guardado na lista. */
+int retira_comeco(Lista *minha_lista, int *dado) {
+	NoLista *removido;
 
 	if (minha_lista->n_elementos == 0) {
 		/* Não posso remover dados de uma lista vazia */
-		return -1;
+		return 0;
 	}
 
-	dado = minha_lista->inicio->dado;
-	proximo = minha_lista->inicio->proximo;
+	removido = minha_lista->inicio;
+	*dado = removido->dado;
+	minha_lista->inicio = removido->proximo;
+	if (minha_lista->inicio == NULL) minha_lista->final = NULL;
+	libera_no(&pool_nos, removido);
 
-	free(minha_lista->inicio);
-	
-	minha_lista->inicio = proximo;
 	minha_lista->n_elementos = minha_lista->n_elementos - 1;
+	conta_remocao();
+	return 1;
+}
+
+/* Versão que retorna o dado diretamente. Para uma lista vazia, retorna -1,
+	 que não pode ser distinguido de um -1 guardado na lista; só deve ser
+	 usada quando se sabe que a lista não está vazia, ou quando os dados
+	 nunca são negativos. */
+int remove_comeco(Lista *minha_lista) {
+	int dado;
+	if (!retira_comeco(minha_lista, &dado)) return -1;
 	return dado;
 }
 
 void desaloca_lista(Lista *minha_lista) {
-	while (minha_lista->n_elementos > 0)
-		remove_comeco(minha_lista);
-	free(minha_lista);
+	int dado;
+	while (retira_comeco(minha_lista, &dado));
+	libera_contabilizado(minha_lista, sizeof(Lista));
+}
+
+/* Pilhas e filas em vetores
+
+	 Na implementação acima, cada elemento é um nó separado, e cada inserção
+	 ou remoção mexe na lista de nós livres do pool e segue ponteiros para
+	 posições quaisquer da memória. Usando vetores, os elementos ficam lado a
+	 lado, sem ponteiros, e a memória é alocada somente quando a estrutura
+	 cresce; em regime (quando o número de elementos oscila em torno de um
+	 valor), nenhuma alocação é feita.
+
+	 A pilha em vetor guarda os elementos em dados[0..n_elementos-1], com o
+	 topo na última posição. Quando o vetor fica cheio, sua capacidade é
+	 dobrada com realloc(). Como cada duplicação copia n elementos e só ocorre
+	 depois de n inserções, o custo amortizado de cada inserção é O(1).
+
+	 As funções têm os mesmos parâmetros e o mesmo comportamento das funções
+	 de Lista (inclusive as duas formas de remoção), de forma que um
+	 programa que usa a pilha ou a fila pode trocar de implementação trocando
+	 apenas os nomes das funções e do tipo. A memória dos vetores também
+	 entra na contabilidade.
+*/
+#define CAPACIDADE_INICIAL 16
+
+typedef struct pilhavetor {
+	int n_elementos;
+	int capacidade;
+	int *dados;
+} PilhaVetor;
+
+PilhaVetor *nova_pilha_vetor() {
+	PilhaVetor *nova;
+	nova = (PilhaVetor*) aloca_contabilizado(sizeof(PilhaVetor));
+	nova->n_elementos = 0;
+	nova->capacidade = CAPACIDADE_INICIAL;
+	nova->dados = (int*) aloca_contabilizado(CAPACIDADE_INICIAL * sizeof(int));
+	return nova;
+}
+
+void cresce_pilha_vetor(PilhaVetor *pilha) {
+	pilha->dados = (int*) realoca_contabilizado(pilha->dados,
+																							 pilha->capacidade * sizeof(int),
+																							 2 * pilha->capacidade * sizeof(int));
+	pilha->capacidade = 2 * pilha->capacidade;
+}
+
+void pilha_insere_comeco(PilhaVetor *pilha, int dado) {
+	if (pilha->n_elementos == pilha->capacidade)
+		cresce_pilha_vetor(pilha);
+	pilha->dados[pilha->n_elementos] = dado;
+	pilha->n_elementos = pilha->n_elementos + 1;
+}
+
+int pilha_retira_comeco(PilhaVetor *pilha, int *dado) {
+	if (pilha->n_elementos == 0) return 0;
+	pilha->n_elementos = pilha->n_elementos - 1;
+	*dado = pilha->dados[pilha->n_elementos];
+	return 1;
+}
+
+int pilha_remove_comeco(PilhaVetor *pilha) {
+	if (pilha->n_elementos == 0) return -1;
+	pilha->n_elementos = pilha->n_elementos - 1;
+	return pilha->dados[pilha->n_elementos];
+}
+
+void desaloca_pilha_vetor(PilhaVetor *pilha) {
+	libera_contabilizado(pilha->dados, pilha->capacidade * sizeof(int));
+	libera_contabilizado(pilha, sizeof(PilhaVetor));
+}
+
+/* A fila em vetor é um buffer circular: os elementos ficam entre as
+	 posições inicio e final, e ambos os índices avançam à medida que
+	 elementos entram e saem, voltando ao começo do vetor quando chegam ao fim.
+	 Se a capacidade é uma potência de 2, a volta ao começo é feita com um E
+	 bit a bit (i & mascara) em vez do resto da divisão (i % capacidade), que
+	 é bem mais lento. Os índices inicio e final crescem sempre; somente ao
+	 acessar o vetor aplicamos a máscara.
+
+	 Quando a fila enche, alocamos um vetor com o dobro do tamanho e copiamos
+	 os elementos para o começo dele, na ordem da fila (o trecho do inicio até
+	 o fim do vetor e depois o trecho do começo do vetor até o final).
+*/
+typedef struct filavetor {
+	int n_elementos;
+	unsigned int mascara;
+	unsigned int inicio;
+	unsigned int final;
+	int *dados;
+} FilaVetor;
+
+FilaVetor *nova_fila_vetor() {
+	FilaVetor *nova;
+	nova = (FilaVetor*) aloca_contabilizado(sizeof(FilaVetor));
+	nova->n_elementos = 0;
+	nova->mascara = CAPACIDADE_INICIAL - 1;
+	nova->inicio = 0;
+	nova->final = 0;
+	nova->dados = (int*) aloca_contabilizado(CAPACIDADE_INICIAL * sizeof(int));
+	return nova;
+}
+
+void cresce_fila_vetor(FilaVetor *fila) {
+	unsigned int capacidade, primeira_parte;
+	int *novos_dados;
+
+	capacidade = fila->mascara + 1;
+	novos_dados = (int*) aloca_contabilizado(2 * capacidade * sizeof(int));
+	primeira_parte = capacidade - (fila->inicio & fila->mascara);
+	memcpy(novos_dados, &(fila->dados[fila->inicio & fila->mascara]),
+				 primeira_parte * sizeof(int));
+	memcpy(&(novos_dados[primeira_parte]), fila->dados,
+				 (capacidade - primeira_parte) * sizeof(int));
+
+	libera_contabilizado(fila->dados, capacidade * sizeof(int));
+	fila->dados = novos_dados;
+	fila->mascara = 2 * capacidade - 1;
+	fila->inicio = 0;
+	fila->final = capacidade;
+}
+
+void fila_insere_final(FilaVetor *fila, int dado) {
+	if (fila->n_elementos == (int) (fila->mascara + 1))
+		cresce_fila_vetor(fila);
+	fila->dados[fila->final & fila->mascara] = dado;
+	fila->final = fila->final + 1;
+	fila->n_elementos = fila->n_elementos + 1;
+}
+
+int fila_retira_comeco(FilaVetor *fila, int *dado) {
+	if (fila->n_elementos == 0) return 0;
+	*dado = fila->dados[fila->inicio & fila->mascara];
+	fila->inicio = fila->inicio + 1;
+	fila->n_elementos = fila->n_elementos - 1;
+	return 1;
+}
+
+int fila_remove_comeco(FilaVetor *fila) {
+	int dado;
+	if (!fila_retira_comeco(fila, &dado)) return -1;
+	return dado;
+}
+
+void desaloca_fila_vetor(FilaVetor *fila) {
+	libera_contabilizado(fila->dados, (fila->mascara + 1) * sizeof(int));
+	libera_contabilizado(fila, sizeof(FilaVetor));
 }
 
 /* Dentre as aplicações de filas, podemos citar o buffer. Um buffer é um
@@ -157,6 +470,11 @@ int fatorial(int N) {
 	return resultado;
 }
 
+/* Nesta simulação, cada chamada empilha outras duas, e o número de
+	 elementos que passam pela pilha cresce tão rápido quanto o próprio
+	 fibonacci(N). Ela serve para mostrar a técnica, mas não é uma boa forma
+	 de calcular a sequência: a aula sobre Fibonacci mostra versões O(N) e
+	 O(log N), inclusive para números com milhares de dígitos. */
 int fibonacci(int N) {
 	Lista *pilha;
 	int resultado;
@@ -180,6 +498,81 @@ int fibonacci(int N) {
 }
 
 
+/* Comparação entre as versões ligada e em vetor. Mantemos N_REGIME
+	 elementos na estrutura e, a cada passo, inserimos um elemento e
+	 retiramos outro, como num buffer em funcionamento contínuo. */
+#define N_OPERACOES 50000000
+#define N_REGIME 1000
+
+void teste_desempenho() {
+	Lista *lista;
+	PilhaVetor *pilha;
+	FilaVetor *fila;
+	long long verificacao;
+	clock_t c1, c2;
+	float t;
+	int i;
+
+	printf("---\n%d insercoes e remocoes com %d elementos na estrutura:\n",
+				 N_OPERACOES, N_REGIME);
+
+	lista = nova_lista();
+	for (i = 0; i < N_REGIME; i++) insere_comeco(lista, i);
+	verificacao = 0;
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		insere_comeco(lista, i);
+		verificacao = verificacao + remove_comeco(lista);
+	}
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Pilha ligada: %e operacoes/s (verificacao = %lld)\n",
+				 2*N_OPERACOES/t, verificacao);
+	desaloca_lista(lista);
+
+	pilha = nova_pilha_vetor();
+	for (i = 0; i < N_REGIME; i++) pilha_insere_comeco(pilha, i);
+	verificacao = 0;
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		pilha_insere_comeco(pilha, i);
+		verificacao = verificacao + pilha_remove_comeco(pilha);
+	}
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Pilha em vetor: %e operacoes/s (verificacao = %lld)\n",
+				 2*N_OPERACOES/t, verificacao);
+	desaloca_pilha_vetor(pilha);
+
+	lista = nova_lista();
+	for (i = 0; i < N_REGIME; i++) insere_final(lista, i);
+	verificacao = 0;
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		insere_final(lista, i);
+		verificacao = verificacao + remove_comeco(lista);
+	}
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Fila ligada: %e operacoes/s (verificacao = %lld)\n",
+				 2*N_OPERACOES/t, verificacao);
+	desaloca_lista(lista);
+
+	fila = nova_fila_vetor();
+	for (i = 0; i < N_REGIME; i++) fila_insere_final(fila, i);
+	verificacao = 0;
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		fila_insere_final(fila, i);
+		verificacao = verificacao + fila_remove_comeco(fila);
+	}
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Fila em vetor: %e operacoes/s (verificacao = %lld)\n",
+				 2*N_OPERACOES/t, verificacao);
+	desaloca_fila_vetor(fila);
+}
+
 int main() {
 	Lista *fila;
 	Lista *pilha;
@@ -197,6 +590,9 @@ int main() {
 	for (i = 0; i < 5; i++) {
 		printf("%d\t%d\n", remove_comeco(fila), remove_comeco(pilha));
 	}
+	insere_final(fila, -1);
+	printf("retira_comeco() numa fila com o dado -1: %d\n", retira_comeco(fila, &i));
+	printf("retira_comeco() numa fila vazia: %d\n", retira_comeco(fila, &i));
 
 	desaloca_lista(fila);
 	desaloca_lista(pilha);
@@ -206,6 +602,12 @@ int main() {
 	for (int i = 1; i < 7; i++) {
 		printf("Fibonacci(%d) = %d\n", i, fibonacci(i));
 	}
+
+	teste_desempenho();
+
+	printf("---\nMemoria usada pelas pilhas e filas:\n");
+	imprime_estatisticas();
+	desaloca_pool(&pool_nos);
 	return 0;
 }
 
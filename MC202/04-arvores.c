@@ -155,41 +155,47 @@ NoArvore **minimo(NoArvore **arvore) {
 }
 
 /* Para remover um valor de uma árvore de busca, devemos tomar o cuidado
-	 de garantir que os nós restantes mantenham suas propriedades. Assim, devemos
-	 re-organizar os nós restantes de forma que o nó removido seja substituído
-	 adequadamente por um de seus filhos - em nosso caso, o nó de valor mínimo de seu
-	 filho direito:
+	 de garantir que os nós restantes mantenham suas propriedades. Há três
+	 casos:
+	 * se o nó não tem filho esquerdo, ele é substituído pelo filho direito
+	   (que pode ser NULL, se o nó é uma folha);
+	 * se o nó não tem filho direito, ele é substituído pelo filho esquerdo;
+	 * se o nó tem os dois filhos, ele é substituído pelo nó de valor mínimo
+	   de seu filho direito. Esse nó não tem filho esquerdo, mas pode ter um
+	   filho direito, que ocupa o lugar dele antes de ele subir.
 */
 void remove_pai(NoArvore **arvore) {
-	NoArvore *pai = (*arvore);
+	NoArvore *pai;
+	NoArvore **min_dir;
+	NoArvore *sucessor;
 
 	if (arvore == NULL) return;
 	if (*arvore == NULL) return;
+	pai = (*arvore);
 
-	NoArvore **min_dir;
-	min_dir = minimo( & ((*arvore)->f_direito));
-
-	if (min_dir != NULL) {
-		if (pai->f_esquerdo != (*min_dir)) /* evitar a auto-referência! */
-			(*min_dir)->f_esquerdo = pai->f_esquerdo;
-		if (pai->f_direito != (*min_dir))
-			(*min_dir)->f_direito = pai->f_direito;
-
-		(*arvore) = (*min_dir);
-		(*min_dir) = NULL;
-		free(pai);
+	if (pai->f_esquerdo == NULL) {
+		(*arvore) = pai->f_direito;
+	} else if (pai->f_direito == NULL) {
+		(*arvore) = pai->f_esquerdo;
 	} else {
-		(*arvore) = NULL;
+		min_dir = minimo( & (pai->f_direito));
+		sucessor = (*min_dir);
+		(*min_dir) = sucessor->f_direito; /* religa o filho direito do mínimo */
+		sucessor->f_esquerdo = pai->f_esquerdo;
+		sucessor->f_direito = pai->f_direito;
+		(*arvore) = sucessor;
 	}
-	
+	free(pai);
 }
 
 void remove_valor(NoArvore **arvore, int valor) {
-	/* Retorna 1 se o valor existe na árvore e 0 caso contrário */
+	/* Remove uma ocorrência do valor, se ele existir na árvore. Depois de
+		 remove_pai(), o nó atual já é outro, então não podemos continuar
+		 descendo a partir dele. */
 	if ( (*arvore) == NULL) return;
 	if (valor == (*arvore)->dado) remove_pai(arvore);
-	if (valor < (*arvore)->dado) remove_valor(  & ((*arvore)->f_esquerdo), valor);
-	if (valor > (*arvore)->dado) remove_valor(  & ((*arvore)->f_direito), valor);
+	else if (valor < (*arvore)->dado) remove_valor(  & ((*arvore)->f_esquerdo), valor);
+	else remove_valor(  & ((*arvore)->f_direito), valor);
 }
 
 
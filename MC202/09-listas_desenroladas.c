@@ -0,0 +1,362 @@
+/* Listas desenroladas
+
+	 Em uma lista ligada simples, cada nó guarda um único dado e um ponteiro
+	 para o próximo nó. Numa máquina de 64 bits, um NoLista ocupa 16 bytes, dos
+	 quais 8 são o ponteiro - ou seja, metade da memória da lista é gasta
+	 apenas com a ligação entre os nós. Além disso, a varredura de uma lista
+	 ligada é lenta: para chegar ao próximo dado, é preciso ler o ponteiro do
+	 nó atual, e cada nó pode estar em um lugar diferente da memória.
+
+	 O processador não lê a memória byte a byte, e sim em blocos contínuos
+	 chamados linhas de cache (tipicamente de 64 bytes). Ler um dado que já
+	 está numa linha de cache é muito mais rápido que buscar uma linha nova
+	 na memória principal. Assim, uma lista ligada simples paga, a cada
+	 elemento, o custo de buscar uma nova linha de cache.
+
+	 Uma lista desenrolada (unrolled linked list) junta as duas ideias: é
+	 uma lista ligada de pequenos vetores. Cada nó ocupa exatamente uma linha
+	 de cache e guarda vários dados, além do número de dados ocupados e do
+	 ponteiro para o próximo nó:
+
+	 [3 | 5 8 2 . . ] -> [4 | 1 9 7 6 . ] -> [2 | 4 0 . . . ] -> NULL
+
+	 Assim, uma única leitura da memória traz vários elementos de uma vez, e
+	 o espaço gasto com ponteiros é dividido entre todos os dados do nó.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINHA_CACHE 64
+
+/* Um ponteiro (8 bytes) e um contador (4 bytes) deixam espaço para 13
+	 inteiros de 4 bytes numa linha de cache de 64 bytes: */
+#define DADOS_POR_NO 13
+
+typedef struct nodesenrolado {
+	struct nodesenrolado *proximo;
+	int n; /* Quantas posições de dados[] estão ocupadas */
+	int dados[DADOS_POR_NO];
+} NoDesenrolado;
+
+/* Assim como na aula anterior, guardamos um descritor com ponteiros para o
+	 primeiro e para o último nó e o número total de elementos: */
+typedef struct listadesenrolada {
+	int n_elementos;
+	int n_nos;
+	NoDesenrolado *inicio;
+	NoDesenrolado *final;
+} ListaDesenrolada;
+
+/* Para que cada nó ocupe uma única linha de cache (e não fique dividido
+	 entre duas), ele é alocado com aligned_alloc(), que garante que o
+	 endereço retornado é múltiplo do alinhamento pedido: */
+NoDesenrolado *novo_no_desenrolado() {
+	NoDesenrolado *no;
+	no = (NoDesenrolado *) aligned_alloc(LINHA_CACHE, sizeof(NoDesenrolado));
+	if (no == NULL) return NULL;
+	no->proximo = NULL;
+	no->n = 0;
+	return no;
+}
+
+ListaDesenrolada *nova_lista_desenrolada() {
+	ListaDesenrolada *l;
+	l = (ListaDesenrolada *) malloc(sizeof(ListaDesenrolada));
+	l->n_elementos = 0;
+	l->n_nos = 0;
+	l->inicio = NULL;
+	l->final = NULL;
+	return l;
+}
+
+/* Para inserir no final, usamos o espaço livre do último nó. Somente quando
+	 ele está cheio é preciso alocar um novo nó: */
+int insere_final(ListaDesenrolada *l, int dado) {
+	/* Retorna 1 em caso de sucesso e 0 caso não haja memória */
+	NoDesenrolado *no;
+
+	if ((l->final == NULL) || (l->final->n == DADOS_POR_NO)) {
+		no = novo_no_desenrolado();
+		if (no == NULL) return 0;
+		if (l->final == NULL) l->inicio = no;
+		else l->final->proximo = no;
+		l->final = no;
+		l->n_nos = l->n_nos + 1;
+	}
+
+	l->final->dados[l->final->n] = dado;
+	l->final->n = l->final->n + 1;
+	l->n_elementos = l->n_elementos + 1;
+	return 1;
+}
+
+/* Para inserir no começo, deslocamos os dados do primeiro nó uma posição
+	 para a direita. Isso custa, no máximo, DADOS_POR_NO cópias, ou seja, O(1)
+	 em relação ao tamanho da lista: */
+int insere_comeco(ListaDesenrolada *l, int dado) {
+	/* Retorna 1 em caso de sucesso e 0 caso não haja memória */
+	NoDesenrolado *no;
+
+	if ((l->inicio == NULL) || (l->inicio->n == DADOS_POR_NO)) {
+		no = novo_no_desenrolado();
+		if (no == NULL) return 0;
+		no->proximo = l->inicio;
+		if (l->inicio == NULL) l->final = no;
+		l->inicio = no;
+		l->n_nos = l->n_nos + 1;
+	}
+
+	no = l->inicio;
+	memmove(&(no->dados[1]), &(no->dados[0]), no->n * sizeof(int));
+	no->dados[0] = dado;
+	no->n = no->n + 1;
+	l->n_elementos = l->n_elementos + 1;
+	return 1;
+}
+
+/* A varredura percorre os nós e, dentro de cada nó, o vetor de dados: */
+void imprime_lista(ListaDesenrolada *l) {
+	NoDesenrolado *no;
+	int i;
+
+	for (no = l->inicio; no != NULL; no = no->proximo)
+		for (i = 0; i < no->n; i++)
+			printf("%d\n", no->dados[i]);
+}
+
+long long soma_lista(ListaDesenrolada *l) {
+	NoDesenrolado *no;
+	long long soma;
+	int i;
+
+	soma = 0;
+	for (no = l->inicio; no != NULL; no = no->proximo)
+		for (i = 0; i < no->n; i++)
+			soma = soma + no->dados[i];
+	return soma;
+}
+
+/* A concatenação liga o último nó da primeira lista ao primeiro nó da
+	 segunda, como antes. Se os dados dos dois nós da emenda couberem em um
+	 só, juntamos esses nós para não deixar nós quase vazios no meio da lista.
+	 A segunda lista fica vazia, pois seus nós passam a pertencer à primeira: */
+void concatena_listas(ListaDesenrolada *l_inicio, ListaDesenrolada *l_fim) {
+	NoDesenrolado *emenda;
+
+	if (l_fim->inicio == NULL) return;
+
+	if (l_inicio->inicio == NULL) {
+		l_inicio->inicio = l_fim->inicio;
+		l_inicio->final = l_fim->final;
+	} else {
+		emenda = l_fim->inicio;
+		if (l_inicio->final->n + emenda->n <= DADOS_POR_NO) {
+			memcpy(&(l_inicio->final->dados[l_inicio->final->n]), emenda->dados,
+						 emenda->n * sizeof(int));
+			l_inicio->final->n = l_inicio->final->n + emenda->n;
+			l_inicio->final->proximo = emenda->proximo;
+			if (emenda->proximo != NULL) l_inicio->final = l_fim->final;
+			free(emenda);
+			l_fim->n_nos = l_fim->n_nos - 1;
+		} else {
+			l_inicio->final->proximo = emenda;
+			l_inicio->final = l_fim->final;
+		}
+	}
+
+	l_inicio->n_elementos = l_inicio->n_elementos + l_fim->n_elementos;
+	l_inicio->n_nos = l_inicio->n_nos + l_fim->n_nos;
+	l_fim->inicio = NULL;
+	l_fim->final = NULL;
+	l_fim->n_elementos = 0;
+	l_fim->n_nos = 0;
+}
+
+/* Inverter a lista requer duas operações: inverter a ordem dos nós (como em
+	 inverte_lista() da aula anterior) e inverter o vetor de dados dentro de
+	 cada nó: */
+void inverte_lista(ListaDesenrolada *l) {
+	NoDesenrolado *atual;
+	NoDesenrolado *anterior;
+	NoDesenrolado *prox;
+	int i;
+	int t;
+
+	anterior = NULL;
+	atual = l->inicio;
+	l->final = atual;
+	while (atual != NULL) {
+		for (i = 0; i < atual->n / 2; i++) {
+			t = atual->dados[i];
+			atual->dados[i] = atual->dados[atual->n - 1 - i];
+			atual->dados[atual->n - 1 - i] = t;
+		}
+		prox = atual->proximo;
+		atual->proximo = anterior;
+		anterior = atual;
+		atual = prox;
+	}
+	l->inicio = anterior;
+}
+
+/* Na cópia profunda, aproveitamos para compactar a lista: a cópia é
+	 construída com insere_final(), que só aloca um novo nó quando o anterior
+	 está cheio. Assim, mesmo que a lista original tenha nós parcialmente
+	 ocupados, a cópia usa o menor número possível de nós: */
+ListaDesenrolada *copia_profunda(ListaDesenrolada *origem) {
+	ListaDesenrolada *copia;
+	NoDesenrolado *no;
+	int i;
+
+	copia = nova_lista_desenrolada();
+	for (no = origem->inicio; no != NULL; no = no->proximo)
+		for (i = 0; i < no->n; i++)
+			insere_final(copia, no->dados[i]);
+	return copia;
+}
+
+void desaloca_lista(ListaDesenrolada *l) {
+	NoDesenrolado *no;
+	NoDesenrolado *prox;
+
+	no = l->inicio;
+	while (no != NULL) {
+		prox = no->proximo;
+		free(no);
+		no = prox;
+	}
+	free(l);
+}
+
+/* Para comparar com a lista ligada clássica, usamos o NoLista das aulas
+	 anteriores, com um malloc() por nó: */
+typedef struct nolista {
+	int dado;
+	struct nolista *proximo;
+} NoLista;
+
+NoLista *constroi_lista_classica(int n) {
+	NoLista *inicio;
+	NoLista *final;
+	NoLista *no;
+	int i;
+
+	inicio = NULL;
+	final = NULL;
+	for (i = 0; i < n; i++) {
+		no = (NoLista *) malloc(sizeof(NoLista));
+		no->dado = i;
+		no->proximo = NULL;
+		if (final == NULL) inicio = no;
+		else final->proximo = no;
+		final = no;
+	}
+	return inicio;
+}
+
+long long soma_lista_classica(NoLista *lista) {
+	long long soma = 0;
+	while (lista != NULL) {
+		soma = soma + lista->dado;
+		lista = lista->proximo;
+	}
+	return soma;
+}
+
+void desaloca_lista_classica(NoLista *lista) {
+	NoLista *prox;
+	while (lista != NULL) {
+		prox = lista->proximo;
+		free(lista);
+		lista = prox;
+	}
+}
+
+#define N_TESTE 10000000
+#define N_VARREDURAS 10
+
+int main() {
+	ListaDesenrolada *l1;
+	ListaDesenrolada *l2;
+	ListaDesenrolada *l3;
+	NoLista *classica;
+	int i;
+	clock_t c1, c2;
+	float tc, td;
+	long long soma;
+
+	l1 = nova_lista_desenrolada();
+	l2 = nova_lista_desenrolada();
+	for (i = 0; i < 5; i++) {
+		insere_final(l1, i);
+		insere_comeco(l2, i+10);
+	}
+	printf("Lista 1\n");
+	imprime_lista(l1);
+	printf("Lista 2\n");
+	imprime_lista(l2);
+
+	printf("Concatenando e invertendo\n");
+	concatena_listas(l1, l2);
+	inverte_lista(l1);
+	l3 = copia_profunda(l1);
+	insere_final(l3, 100);
+	printf("Lista 1 (%d elementos, %d nos)\n", l1->n_elementos, l1->n_nos);
+	imprime_lista(l1);
+	printf("Lista 3 (%d elementos, %d nos)\n", l3->n_elementos, l3->n_nos);
+	imprime_lista(l3);
+	desaloca_lista(l1);
+	desaloca_lista(l2);
+	desaloca_lista(l3);
+
+	printf("---\nVarrendo %d vezes listas de %d elementos\n", N_VARREDURAS, N_TESTE);
+	classica = constroi_lista_classica(N_TESTE);
+	c1 = clock();
+	soma = 0;
+	for (i = 0; i < N_VARREDURAS; i++)
+		soma = soma + soma_lista_classica(classica);
+	c2 = clock();
+	tc = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Lista classica: %f segundos (soma = %lld)\n", tc, soma);
+	printf("  %d bytes por elemento (sem contar o controle do malloc)\n",
+				 (int) sizeof(NoLista));
+	desaloca_lista_classica(classica);
+
+	l1 = nova_lista_desenrolada();
+	for (i = 0; i < N_TESTE; i++)
+		insere_final(l1, i);
+	c1 = clock();
+	soma = 0;
+	for (i = 0; i < N_VARREDURAS; i++)
+		soma = soma + soma_lista(l1);
+	c2 = clock();
+	td = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Lista desenrolada: %f segundos (soma = %lld)\n", td, soma);
+	printf("  %f bytes por elemento\n",
+				 (l1->n_nos * (float) sizeof(NoDesenrolado)) / l1->n_elementos);
+	desaloca_lista(l1);
+
+	printf("A lista desenrolada foi %f vezes mais rapida\n", tc/td);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -olistas_desenroladas 09-listas_desenroladas.c
+	 ./listas_desenroladas
+*/
+
+/* Exercícios
+
+	 1) Escreva uma função que remove o primeiro elemento de uma lista
+	 desenrolada. O que fazer quando o primeiro nó fica vazio?
+
+	 2) Escreva uma função que insere um dado na posição k da lista
+	 desenrolada. Quando o nó em que o dado deveria entrar está cheio,
+	 divida-o em dois nós, cada um com metade dos dados.
+
+	 3) Qual é a complexidade de se encontrar o k-ésimo elemento de uma
+	 lista desenrolada? Compare com a lista ligada simples.
+*/
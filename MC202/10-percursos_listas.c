@@ -0,0 +1,363 @@
+/* Percursos eficientes em listas ligadas
+
+	 Praticamente todas as operações que vimos sobre listas ligadas -
+	 imprimir, concatenar, copiar, somar - têm a mesma estrutura: um ponteiro
+	 começa no primeiro nó e segue o campo proximo até encontrar NULL, e uma
+	 operação qualquer é executada em cada nó. Nesta aula, vamos escrever essa
+	 estrutura uma única vez, de forma genérica, e estudar por que ela pode
+	 ser tão lenta.
+
+	 Ao contrário de um vetor, em que o endereço do elemento i+1 é conhecido
+	 de antemão, numa lista só descobrimos onde está o próximo nó depois de ler
+	 o nó atual. Se o próximo nó não estiver na memória cache, o processador
+	 fica parado esperando a memória principal (algo como 100 ns, tempo em que
+	 centenas de instruções poderiam ter sido executadas). Isso se chama
+	 perseguição de ponteiros (pointer chasing).
+
+	 Duas técnicas ajudam a diminuir esse custo:
+
+	 1) Pré-busca (prefetch): podemos pedir ao processador que comece a
+	 trazer para a cache um nó que ainda vamos visitar, enquanto trabalhamos
+	 no nó atual. No GCC, isso é feito com __builtin_prefetch(endereço).
+	 Numa lista, só conhecemos o endereço dos nós seguintes seguindo os
+	 ponteiros, então mantemos um segundo ponteiro alguns nós à frente. Esse
+	 ponteiro também persegue os ponteiros, mas permite que a espera pela
+	 memória aconteça enquanto o trabalho dos nós anteriores é realizado.
+
+	 2) Reorganização da lista: se os nós estiverem na memória na mesma ordem
+	 em que aparecem na lista, o acesso passa a ser sequencial, como num vetor,
+	 e o próprio processador percebe o padrão e antecipa as leituras. Podemos
+	 reorganizar uma lista cujos nós estejam espalhados para recuperar essa
+	 propriedade.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct nolista {
+	int dado;
+	struct nolista *proximo;
+} NoLista;
+
+/* Os nós vêm do pool de nós visto nas aulas anteriores: */
+#define NOS_POR_BLOCO 65536
+
+typedef struct blocopool {
+	struct blocopool *proximo;
+	NoLista nos[NOS_POR_BLOCO];
+} BlocoPool;
+
+typedef struct poolnos {
+	BlocoPool *blocos; /* Bloco atual (o último alocado) */
+	int usados; /* Quantos nós do bloco atual já foram entregues */
+	NoLista *livres; /* Nós devolvidos, prontos para reuso */
+} PoolNos;
+
+PoolNos pool_nos = {NULL, NOS_POR_BLOCO, NULL};
+
+NoLista *aloca_no(PoolNos *pool) {
+	NoLista *no;
+	BlocoPool *bloco;
+
+	if (pool->livres != NULL) {
+		no = pool->livres;
+		pool->livres = no->proximo;
+		return no;
+	}
+
+	if (pool->usados == NOS_POR_BLOCO) {
+		bloco = (BlocoPool *) malloc (sizeof(BlocoPool));
+		if (bloco == NULL) return NULL;
+		bloco->proximo = pool->blocos;
+		pool->blocos = bloco;
+		pool->usados = 0;
+	}
+
+	no = &(pool->blocos->nos[pool->usados]);
+	pool->usados = pool->usados + 1;
+	return no;
+}
+
+void desaloca_pool(PoolNos *pool) {
+	BlocoPool *bloco;
+
+	while (pool->blocos != NULL) {
+		bloco = pool->blocos;
+		pool->blocos = bloco->proximo;
+		free(bloco);
+	}
+	pool->usados = NOS_POR_BLOCO;
+	pool->livres = NULL;
+}
+
+/* Para a pré-busca, o ponteiro de pré-busca anda DISTANCIA_PREFETCH nós à
+	 frente do ponteiro atual. A cada passo, ele avança um nó e pede que o nó
+	 seguinte comece a ser trazido para a cache: */
+#define DISTANCIA_PREFETCH 8
+
+NoLista *avanca_prefetch(NoLista *adiante) {
+	if (adiante == NULL) return NULL;
+	adiante = adiante->proximo;
+	if (adiante != NULL) __builtin_prefetch(adiante->proximo);
+	return adiante;
+}
+
+NoLista *inicia_prefetch(NoLista *lista) {
+	int i;
+	for (i = 0; (i < DISTANCIA_PREFETCH) && (lista != NULL); i++)
+		lista = avanca_prefetch(lista);
+	return lista;
+}
+
+/* A forma mais rápida de percorrer a lista é uma macro: o corpo do laço é
+	 escrito diretamente por quem a utiliza, sem nenhuma chamada de função.
+	 A macro declara o ponteiro "no" e um ponteiro auxiliar de pré-busca:
+
+	 PARA_CADA_NO(no, lista) {
+	   soma = soma + no->dado;
+	 }
+*/
+#define PARA_CADA_NO(no, lista) \
+	for (NoLista *no = (lista), *adiante_##no = inicia_prefetch(no); \
+			 no != NULL; \
+			 no = no->proximo, adiante_##no = avanca_prefetch(adiante_##no))
+
+/* Quando a operação é escolhida durante a execução, usamos ponteiros para
+	 funções. Definimos três formas clássicas de percurso:
+	 - percorre_lista (foreach): chama uma função para cada dado, com um
+	   contexto qualquer fornecido por quem chama;
+	 - mapeia_lista (map): substitui cada dado por f(dado);
+	 - reduz_lista (reduce): combina todos os dados num único valor, como
+	   uma soma ou um máximo. */
+typedef void (*FuncaoVisita)(int dado, void *contexto);
+typedef int (*FuncaoMapa)(int dado);
+typedef long long (*FuncaoReducao)(long long acumulado, int dado);
+
+void percorre_lista(NoLista *lista, FuncaoVisita f, void *contexto) {
+	PARA_CADA_NO(no, lista) {
+		f(no->dado, contexto);
+	}
+}
+
+void mapeia_lista(NoLista *lista, FuncaoMapa f) {
+	PARA_CADA_NO(no, lista) {
+		no->dado = f(no->dado);
+	}
+}
+
+long long reduz_lista(NoLista *lista, FuncaoReducao f, long long inicial) {
+	long long acumulado = inicial;
+	PARA_CADA_NO(no, lista) {
+		acumulado = f(acumulado, no->dado);
+	}
+	return acumulado;
+}
+
+/* Algumas funções para usar com o percurso genérico: */
+void imprime_dado(int dado, void *contexto) {
+	printf("%s%d", (char *) contexto, dado);
+}
+
+int dobra(int dado) {
+	return 2 * dado;
+}
+
+long long soma(long long acumulado, int dado) {
+	return acumulado + dado;
+}
+
+long long maximo(long long acumulado, int dado) {
+	if (dado > acumulado) return dado;
+	return acumulado;
+}
+
+/* Para reorganizar a lista em ordem de endereços, guardamos seus dados em
+	 um vetor (na ordem da lista) e os endereços de seus nós em outro. Os
+	 endereços são ordenados, e então os nós são religados na ordem crescente
+	 de endereços, recebendo os dados na ordem original. Assim, a lista
+	 continua com os mesmos dados na mesma ordem e usando os mesmos nós, mas
+	 percorrê-la passa a ser um acesso (quase) sequencial à memória.
+
+	 Atenção: depois dessa operação, um ponteiro para um nó específico da
+	 lista pode passar a apontar para outro dado! Retorna 1 em caso de sucesso
+	 e 0 caso não haja memória para os vetores auxiliares. */
+int compara_enderecos(const void *a, const void *b) {
+	NoLista *pa = *(NoLista **) a;
+	NoLista *pb = *(NoLista **) b;
+	if (pa < pb) return -1;
+	if (pa > pb) return 1;
+	return 0;
+}
+
+int reordena_por_endereco(NoLista **lista) {
+	NoLista **nos;
+	int *dados;
+	int n;
+	int i;
+
+	n = 0;
+	PARA_CADA_NO(no, *lista) {
+		n++;
+	}
+	if (n == 0) return 1;
+
+	nos = (NoLista **) malloc(n * sizeof(NoLista *));
+	dados = (int *) malloc(n * sizeof(int));
+	if ((nos == NULL) || (dados == NULL)) {
+		free(nos);
+		free(dados);
+		return 0;
+	}
+
+	i = 0;
+	PARA_CADA_NO(no, *lista) {
+		nos[i] = no;
+		dados[i] = no->dado;
+		i++;
+	}
+
+	qsort(nos, n, sizeof(NoLista *), compara_enderecos);
+
+	for (i = 0; i < n; i++) {
+		nos[i]->dado = dados[i];
+		if (i + 1 < n) nos[i]->proximo = nos[i + 1];
+		else nos[i]->proximo = NULL;
+	}
+	(*lista) = nos[0];
+
+	free(nos);
+	free(dados);
+	return 1;
+}
+
+/* Para os testes, construímos listas de duas formas: com nós alocados em
+	 sequência (a lista segue a ordem da memória) ou com nós embaralhados
+	 (cada nó da lista está num lugar aleatório do pool): */
+NoLista *constroi_lista(int n, int embaralhada) {
+	NoLista **nos;
+	NoLista *t;
+	NoLista *lista;
+	int i;
+	int j;
+
+	nos = (NoLista **) malloc(n * sizeof(NoLista *));
+	for (i = 0; i < n; i++)
+		nos[i] = aloca_no(&pool_nos);
+
+	if (embaralhada) {
+		for (i = n - 1; i > 0; i--) { /* Embaralhamento de Fisher-Yates */
+			j = rand() % (i + 1);
+			t = nos[i];
+			nos[i] = nos[j];
+			nos[j] = t;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		nos[i]->dado = i;
+		if (i + 1 < n) nos[i]->proximo = nos[i + 1];
+		else nos[i]->proximo = NULL;
+	}
+	lista = nos[0];
+	free(nos);
+	return lista;
+}
+
+long long soma_simples(NoLista *lista) {
+	long long s = 0;
+	while (lista != NULL) {
+		s = s + lista->dado;
+		lista = lista->proximo;
+	}
+	return s;
+}
+
+long long soma_prefetch(NoLista *lista) {
+	long long s = 0;
+	PARA_CADA_NO(no, lista) {
+		s = s + no->dado;
+	}
+	return s;
+}
+
+#define N_TESTE 10000000
+
+void mede(char *nome, NoLista *lista) {
+	clock_t c1, c2;
+	long long s;
+
+	c1 = clock();
+	s = soma_simples(lista);
+	c2 = clock();
+	printf("%s\tlaco simples\t%f ns/no\t(soma = %lld)\n", nome,
+				 1e9 * (c2-c1) / ((double) CLOCKS_PER_SEC * N_TESTE), s);
+
+	c1 = clock();
+	s = soma_prefetch(lista);
+	c2 = clock();
+	printf("%s\tPARA_CADA_NO\t%f ns/no\t(soma = %lld)\n", nome,
+				 1e9 * (c2-c1) / ((double) CLOCKS_PER_SEC * N_TESTE), s);
+
+	c1 = clock();
+	s = reduz_lista(lista, soma, 0);
+	c2 = clock();
+	printf("%s\treduz_lista\t%f ns/no\t(soma = %lld)\n", nome,
+				 1e9 * (c2-c1) / ((double) CLOCKS_PER_SEC * N_TESTE), s);
+}
+
+int main() {
+	NoLista *lista;
+	clock_t c1, c2;
+
+	srand(1);
+	lista = constroi_lista(10, 1);
+	printf("Lista:");
+	percorre_lista(lista, imprime_dado, " ");
+	mapeia_lista(lista, dobra);
+	printf("\nDobrada:");
+	percorre_lista(lista, imprime_dado, " ");
+	printf("\nSoma: %lld, maximo: %lld\n", reduz_lista(lista, soma, 0),
+				 reduz_lista(lista, maximo, 0));
+	reordena_por_endereco(&lista);
+	printf("Reordenada por endereco:");
+	percorre_lista(lista, imprime_dado, " ");
+	printf("\n---\n");
+	desaloca_pool(&pool_nos);
+
+	lista = constroi_lista(N_TESTE, 0);
+	mede("sequencial", lista);
+	desaloca_pool(&pool_nos);
+
+	lista = constroi_lista(N_TESTE, 1);
+	mede("embaralhada", lista);
+
+	c1 = clock();
+	reordena_por_endereco(&lista);
+	c2 = clock();
+	printf("reordena_por_endereco: %f segundos\n", (c2-c1) / (float) CLOCKS_PER_SEC);
+	mede("reordenada", lista);
+	desaloca_pool(&pool_nos);
+
+	return 0;
+}
+
+/* Para executar:
+	 gcc -opercursos_listas 10-percursos_listas.c
+	 ./percursos_listas
+*/
+
+/* Exercícios
+
+	 1) Compare os tempos obtidos para a lista sequencial e para a lista
+	 embaralhada. Quantas vezes a lista embaralhada é mais lenta? Por que a
+	 pré-busca ajuda pouco quando o trabalho feito em cada nó é apenas
+	 uma soma?
+
+	 2) Usando reduz_lista(), escreva uma função que conta quantos elementos
+	 pares há em uma lista.
+
+	 3) Escreva uma versão de reordena_por_endereco() que não utilize o
+	 vetor auxiliar de dados. Dica: ordene os nós pelo endereço e depois
+	 ordene os dados pelos índices originais.
+*/
@@ -0,0 +1,364 @@
+/* Listas duplamente ligadas com nó sentinela
+
+	 Numa lista ligada simples, cada nó conhece apenas o seu sucessor. Isso
+	 torna algumas operações caras: para remover o último nó, ou um nó
+	 qualquer do meio da lista, precisamos do nó anterior a ele, e a única
+	 forma de encontrá-lo é varrer a lista desde o começo - O(N).
+
+	 Numa lista duplamente ligada, cada nó guarda também um ponteiro para o
+	 nó anterior:
+
+	 NULL <- [A] <-> [B] <-> [C] -> NULL
+
+	 Dado um ponteiro para um nó qualquer, podemos removê-lo ou inserir um
+	 novo nó antes ou depois dele em O(1), e podemos percorrer a lista nos
+	 dois sentidos.
+
+	 Os casos especiais (lista vazia, inserir antes do primeiro nó, remover
+	 o último nó...) tornam o código dessas operações cheio de testes. Para
+	 eliminá-los, usamos um nó sentinela (ou nó cabeça): um nó que não guarda
+	 dados, e que fica ao mesmo tempo antes do primeiro e depois do último nó
+	 da lista, fechando um círculo:
+
+	     +-> [sentinela] <-> [A] <-> [B] <-> [C] <-+
+	     +-----------------------------------------+
+
+	 Uma lista vazia é apenas a sentinela apontando para si mesma. Como todo
+	 nó de dados sempre tem um anterior e um próximo, nenhuma operação
+	 precisa testar ponteiros nulos.
+
+	 Uma aplicação típica é a fila de descarte LRU (least recently used) de
+	 uma cache: os itens usados recentemente são movidos para o começo da
+	 lista, e, quando a cache está cheia, o item do final (o usado há mais
+	 tempo) é descartado. Todas essas operações custam O(1).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct nodupla {
+	int dado;
+	struct nodupla *anterior;
+	struct nodupla *proximo;
+} NoDupla;
+
+typedef struct listadupla {
+	NoDupla sentinela;
+	int n_elementos;
+} ListaDupla;
+
+/* Os nós são alocados a partir de um pool de nós, como nas aulas sobre
+	 listas ligadas simples. A lista de nós livres usa o campo proximo: */
+#define NOS_POR_BLOCO 65536
+
+typedef struct blocopool {
+	struct blocopool *proximo;
+	NoDupla nos[NOS_POR_BLOCO];
+} BlocoPool;
+
+typedef struct poolnos {
+	BlocoPool *blocos; /* Bloco atual (o último alocado) */
+	int usados; /* Quantos nós do bloco atual já foram entregues */
+	NoDupla *livres; /* Nós devolvidos, prontos para reuso */
+} PoolNos;
+
+PoolNos pool_nos = {NULL, NOS_POR_BLOCO, NULL};
+
+NoDupla *aloca_no(PoolNos *pool) {
+	NoDupla *no;
+	BlocoPool *bloco;
+
+	if (pool->livres != NULL) {
+		no = pool->livres;
+		pool->livres = no->proximo;
+		return no;
+	}
+
+	if (pool->usados == NOS_POR_BLOCO) {
+		bloco = (BlocoPool *) malloc (sizeof(BlocoPool));
+		if (bloco == NULL) return NULL;
+		bloco->proximo = pool->blocos;
+		pool->blocos = bloco;
+		pool->usados = 0;
+	}
+
+	no = &(pool->blocos->nos[pool->usados]);
+	pool->usados = pool->usados + 1;
+	return no;
+}
+
+void libera_no(PoolNos *pool, NoDupla *no) {
+	no->proximo = pool->livres;
+	pool->livres = no;
+}
+
+void desaloca_pool(PoolNos *pool) {
+	BlocoPool *bloco;
+
+	while (pool->blocos != NULL) {
+		bloco = pool->blocos;
+		pool->blocos = bloco->proximo;
+		free(bloco);
+	}
+	pool->usados = NOS_POR_BLOCO;
+	pool->livres = NULL;
+}
+
+/* Uma lista começa com a sentinela apontando para si mesma: */
+void inicia_lista(ListaDupla *l) {
+	l->sentinela.anterior = &(l->sentinela);
+	l->sentinela.proximo = &(l->sentinela);
+	l->n_elementos = 0;
+}
+
+NoDupla *primeiro(ListaDupla *l) {
+	/* Retorna NULL se a lista está vazia */
+	if (l->n_elementos == 0) return NULL;
+	return l->sentinela.proximo;
+}
+
+NoDupla *ultimo(ListaDupla *l) {
+	/* Retorna NULL se a lista está vazia */
+	if (l->n_elementos == 0) return NULL;
+	return l->sentinela.anterior;
+}
+
+/* As duas operações básicas são ligar um nó logo depois de outro e
+	 desligar um nó de seus vizinhos. Graças à sentinela, as duas funcionam
+	 da mesma forma em qualquer posição da lista: */
+void liga_depois(NoDupla *local, NoDupla *no) {
+	no->anterior = local;
+	no->proximo = local->proximo;
+	local->proximo->anterior = no;
+	local->proximo = no;
+}
+
+void desliga(NoDupla *no) {
+	no->anterior->proximo = no->proximo;
+	no->proximo->anterior = no->anterior;
+}
+
+/* Com elas, escrevemos as inserções e remoções, todas em O(1). As funções
+	 de inserção retornam o novo nó (para que ele possa ser removido ou
+	 movido depois) ou NULL caso não haja memória: */
+NoDupla *insere_depois(ListaDupla *l, NoDupla *local, int dado) {
+	NoDupla *no;
+
+	no = aloca_no(&pool_nos);
+	if (no == NULL) return NULL;
+	no->dado = dado;
+	liga_depois(local, no);
+	l->n_elementos = l->n_elementos + 1;
+	return no;
+}
+
+NoDupla *insere_antes(ListaDupla *l, NoDupla *local, int dado) {
+	return insere_depois(l, local->anterior, dado);
+}
+
+NoDupla *insere_comeco(ListaDupla *l, int dado) {
+	return insere_depois(l, &(l->sentinela), dado);
+}
+
+NoDupla *insere_final(ListaDupla *l, int dado) {
+	return insere_depois(l, l->sentinela.anterior, dado);
+}
+
+/* Remove o nó da lista e o devolve ao pool. Retorna o dado removido: */
+int remove_no(ListaDupla *l, NoDupla *no) {
+	int dado;
+
+	dado = no->dado;
+	desliga(no);
+	libera_no(&pool_nos, no);
+	l->n_elementos = l->n_elementos - 1;
+	return dado;
+}
+
+/* Na fila LRU, um item acessado vai para o começo da lista: */
+void move_para_comeco(ListaDupla *l, NoDupla *no) {
+	desliga(no);
+	liga_depois(&(l->sentinela), no);
+}
+
+/* Transferir (splice) todos os nós de uma lista para outra, logo depois de
+	 um nó local, também custa O(1): basta religar as duas pontas. A lista
+	 de origem fica vazia. */
+void transfere(ListaDupla *destino, NoDupla *local, ListaDupla *origem) {
+	NoDupla *inicio;
+	NoDupla *fim;
+
+	if (origem->n_elementos == 0) return;
+
+	inicio = origem->sentinela.proximo;
+	fim = origem->sentinela.anterior;
+
+	inicio->anterior = local;
+	fim->proximo = local->proximo;
+	local->proximo->anterior = fim;
+	local->proximo = inicio;
+
+	destino->n_elementos = destino->n_elementos + origem->n_elementos;
+	inicia_lista(origem);
+}
+
+/* Os percursos seguem os ponteiros até voltar à sentinela, em um sentido
+	 ou no outro: */
+void imprime_lista(ListaDupla *l) {
+	NoDupla *no;
+	for (no = l->sentinela.proximo; no != &(l->sentinela); no = no->proximo)
+		printf("%d ", no->dado);
+	printf("\n");
+}
+
+void imprime_lista_reversa(ListaDupla *l) {
+	NoDupla *no;
+	for (no = l->sentinela.anterior; no != &(l->sentinela); no = no->anterior)
+		printf("%d ", no->dado);
+	printf("\n");
+}
+
+/* Para desalocar a lista, devolvemos todos os nós ao pool de uma só vez,
+	 ligando o último nó ao começo da lista de nós livres - O(1): */
+void desaloca_lista(ListaDupla *l) {
+	if (l->n_elementos == 0) return;
+	l->sentinela.anterior->proximo = pool_nos.livres;
+	pool_nos.livres = l->sentinela.proximo;
+	inicia_lista(l);
+}
+
+/* No teste de desempenho, simulamos uma cache LRU com N_LRU itens: cada
+	 item tem um nó na lista, e um vetor guarda o nó de cada item (numa
+	 cache real, esse papel seria de uma tabela de espalhamento). Medimos o
+	 tempo médio de cada operação: */
+#define N_LRU 1000000
+#define N_OPERACOES 10000000
+
+double ns_por_operacao(clock_t c1, clock_t c2, int n) {
+	return 1e9 * (c2 - c1) / ((double) CLOCKS_PER_SEC * n);
+}
+
+void teste_lru() {
+	ListaDupla lru;
+	ListaDupla outra;
+	NoDupla **nos;
+	clock_t c1, c2;
+	int i;
+	int item;
+	long long soma;
+
+	nos = (NoDupla **) malloc(N_LRU * sizeof(NoDupla *));
+	inicia_lista(&lru);
+	inicia_lista(&outra);
+	srand(1);
+
+	c1 = clock();
+	for (i = 0; i < N_LRU; i++)
+		nos[i] = insere_comeco(&lru, i);
+	c2 = clock();
+	printf("insere_comeco\t\t%f ns/op\n", ns_por_operacao(c1, c2, N_LRU));
+
+	/* Acessos aleatórios: o item acessado vai para o começo */
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++)
+		move_para_comeco(&lru, nos[rand() % N_LRU]);
+	c2 = clock();
+	printf("move_para_comeco\t%f ns/op (inclui rand())\n",
+				 ns_por_operacao(c1, c2, N_OPERACOES));
+
+	/* Descarte: remove o item menos usado e insere um novo no começo */
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		item = remove_no(&lru, ultimo(&lru));
+		nos[item] = insere_comeco(&lru, item);
+	}
+	c2 = clock();
+	printf("descarte + insercao\t%f ns/op\n", ns_por_operacao(c1, c2, N_OPERACOES));
+
+	/* Remoção e reinserção de nós do meio da lista */
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		item = rand() % N_LRU;
+		remove_no(&lru, nos[item]);
+		nos[item] = insere_final(&lru, item);
+	}
+	c2 = clock();
+	printf("remocao no meio\t\t%f ns/op (inclui rand())\n",
+				 ns_por_operacao(c1, c2, N_OPERACOES));
+
+	/* Transferências de uma lista inteira para outra e de volta */
+	c1 = clock();
+	for (i = 0; i < N_OPERACOES; i++) {
+		if (i % 2 == 0) transfere(&outra, &(outra.sentinela), &lru);
+		else transfere(&lru, &(lru.sentinela), &outra);
+	}
+	c2 = clock();
+	printf("transfere\t\t%f ns/op\n", ns_por_operacao(c1, c2, N_OPERACOES));
+
+	soma = 0;
+	for (i = 0; i < N_LRU; i++)
+		soma = soma + nos[i]->dado;
+	printf("Itens na cache: %d (soma = %lld)\n", lru.n_elementos, soma);
+
+	desaloca_lista(&lru);
+	free(nos);
+}
+
+int main() {
+	ListaDupla l1;
+	ListaDupla l2;
+	NoDupla *meio;
+	int i;
+
+	inicia_lista(&l1);
+	inicia_lista(&l2);
+	for (i = 0; i < 5; i++) {
+		insere_final(&l1, i);
+		insere_final(&l2, i + 10);
+	}
+	meio = insere_depois(&l1, primeiro(&l1), 100);
+	printf("Lista 1: ");
+	imprime_lista(&l1);
+	printf("Lista 1 ao contrario: ");
+	imprime_lista_reversa(&l1);
+
+	printf("Removendo %d e o ultimo no\n", remove_no(&l1, meio));
+	remove_no(&l1, ultimo(&l1));
+	imprime_lista(&l1);
+
+	printf("Transferindo a lista 2 para depois do primeiro no da lista 1\n");
+	transfere(&l1, primeiro(&l1), &l2);
+	printf("Lista 1 (%d elementos): ", l1.n_elementos);
+	imprime_lista(&l1);
+	printf("Lista 2 (%d elementos): ", l2.n_elementos);
+	imprime_lista(&l2);
+
+	move_para_comeco(&l1, ultimo(&l1));
+	printf("Ultimo no movido para o comeco: ");
+	imprime_lista(&l1);
+	desaloca_lista(&l1);
+
+	printf("---\nCache LRU com %d itens\n", N_LRU);
+	teste_lru();
+	desaloca_pool(&pool_nos);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -olistas_duplas 11-listas_duplas.c
+	 ./listas_duplas
+*/
+
+/* Exercícios
+
+	 1) Escreva uma função que inverte uma lista duplamente ligada com
+	 sentinela. Quantos ponteiros de cada nó precisam ser trocados?
+
+	 2) Escreva uma função que transfere para outra lista apenas os nós
+	 entre dois nós a e b (inclusive) de uma lista. Qual é a complexidade
+	 dessa operação se não for necessário manter o campo n_elementos?
+
+	 3) Implemente uma cache LRU completa, usando a tabela de espalhamento
+	 da aula sobre hashing para encontrar o nó de cada chave.
+*/
@@ -0,0 +1,874 @@
+/* Matrizes esparsas
+
+	 Uma matriz esparsa é uma matriz em que a grande maioria das posições é
+	 zero. Elas aparecem, por exemplo, quando representamos um grafo com
+	 milhões de vértices por sua matriz de adjacências: cada vértice se liga a
+	 poucos outros, e quase toda a matriz é nula. Guardar todas as posições de
+	 uma matriz 10^6 x 10^6 exigiria 10^12 valores; guardar apenas os valores
+	 não-nulos pode exigir alguns milhões.
+
+	 Na aula sobre estruturas ligadas, vimos que uma matriz esparsa pode ser
+	 representada por listas ligadas, com um nó para cada posição não-nula.
+	 Essa representação é simples, mas cada valor custa um nó inteiro (com
+	 ponteiro e índices), e percorrer a matriz é uma sequência de acessos
+	 aleatórios à memória. Nesta aula, veremos os formatos comprimidos, que
+	 guardam os valores não-nulos em vetores contínuos:
+
+	 - COO (coordenadas): três vetores - linha[], coluna[] e valor[] - com uma
+	   posição para cada valor não-nulo, em qualquer ordem. É o formato mais
+	   fácil de construir.
+
+	 - CSR (compressed sparse row): os valores são agrupados por linha. O
+	   vetor indice[] guarda a coluna de cada valor, e o vetor inicio[] tem
+	   uma posição por linha (mais uma): os valores da linha i estão nas
+	   posições inicio[i] até inicio[i+1]-1. Por exemplo:
+
+	       | 5 0 0 2 |        inicio = {0, 2, 2, 4}
+	       | 0 0 0 0 |        indice = {0, 3, 1, 2}
+	       | 0 7 1 0 |        valor  = {5, 2, 7, 1}
+
+	 - CSC (compressed sparse column): o mesmo, mas agrupando os valores por
+	   coluna; indice[] guarda a linha de cada valor.
+
+	 As duas operações mais importantes sobre matrizes esparsas são o produto
+	 de uma matriz por um vetor denso (SpMV, y = A x) e o produto de duas
+	 matrizes esparsas (SpGEMM, C = A B). No formato CSR, as duas percorrem a
+	 matriz linha a linha, lendo a memória sequencialmente, e linhas
+	 diferentes podem ser calculadas de forma independente - ou seja, em
+	 paralelo, por várias threads.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct matrizcoo {
+	int linhas;
+	int colunas;
+	int nnz; /* Número de valores não-nulos */
+	int *linha;
+	int *coluna;
+	double *valor;
+} MatrizCOO;
+
+/* CSR e CSC usam a mesma estrutura. Em CSR, inicio[] tem linhas+1 posições
+	 e indice[] guarda colunas; em CSC, inicio[] tem colunas+1 posições e
+	 indice[] guarda linhas. Dentro de cada linha (ou coluna), os índices
+	 ficam em ordem crescente. */
+typedef struct matrizcomprimida {
+	int linhas;
+	int colunas;
+	int nnz;
+	int *inicio;
+	int *indice;
+	double *valor;
+} MatrizComprimida;
+
+MatrizComprimida *nova_matriz_comprimida(int linhas, int colunas, int n_grupos, int nnz) {
+	MatrizComprimida *m;
+	m = (MatrizComprimida *) malloc(sizeof(MatrizComprimida));
+	m->linhas = linhas;
+	m->colunas = colunas;
+	m->nnz = nnz;
+	m->inicio = (int *) malloc((n_grupos + 1) * sizeof(int));
+	m->indice = (int *) malloc(nnz * sizeof(int));
+	m->valor = (double *) malloc(nnz * sizeof(double));
+	return m;
+}
+
+void desaloca_matriz_comprimida(MatrizComprimida *m) {
+	free(m->inicio);
+	free(m->indice);
+	free(m->valor);
+	free(m);
+}
+
+/* A conversão entre formatos é uma ordenação por contagem (counting sort):
+	 contamos quantos valores há em cada grupo (linha ou coluna), calculamos
+	 as somas acumuladas dessas contagens - que são exatamente o vetor
+	 inicio[] - e copiamos cada valor para a próxima posição livre de seu
+	 grupo. A ordenação é estável: valores de um mesmo grupo mantêm a ordem
+	 em que aparecem na entrada. Tudo custa O(nnz + n_grupos). */
+void agrupa(int n_grupos, int nnz, int *grupo, int *outro, double *valor,
+						int *inicio, int *grupo_saida, int *outro_saida, double *valor_saida) {
+	int *proxima;
+	int i;
+	int p;
+
+	for (i = 0; i <= n_grupos; i++)
+		inicio[i] = 0;
+	for (i = 0; i < nnz; i++)
+		inicio[grupo[i] + 1]++;
+	for (i = 0; i < n_grupos; i++)
+		inicio[i + 1] = inicio[i + 1] + inicio[i];
+
+	proxima = (int *) malloc(n_grupos * sizeof(int));
+	memcpy(proxima, inicio, n_grupos * sizeof(int));
+	for (i = 0; i < nnz; i++) {
+		p = proxima[grupo[i]];
+		proxima[grupo[i]]++;
+		if (grupo_saida != NULL) grupo_saida[p] = grupo[i];
+		outro_saida[p] = outro[i];
+		valor_saida[p] = valor[i];
+	}
+	free(proxima);
+}
+
+/* Para obter CSR com as colunas de cada linha em ordem, agrupamos primeiro
+	 por coluna e depois, de forma estável, por linha (é a ideia do radix
+	 sort). CSC é obtido da mesma forma, trocando os papéis: */
+MatrizComprimida *coo_para_comprimida(MatrizCOO *coo, int por_coluna) {
+	MatrizComprimida *m;
+	int *inicio_tmp;
+	int *grupo_tmp;
+	int *outro_tmp;
+	double *valor_tmp;
+	int *primeiro;
+	int *segundo;
+	int n_primeiro;
+	int n_segundo;
+
+	if (por_coluna) { /* CSC: ordena por linha, depois agrupa por coluna */
+		primeiro = coo->linha; n_primeiro = coo->linhas;
+		segundo = coo->coluna; n_segundo = coo->colunas;
+	} else { /* CSR: ordena por coluna, depois agrupa por linha */
+		primeiro = coo->coluna; n_primeiro = coo->colunas;
+		segundo = coo->linha; n_segundo = coo->linhas;
+	}
+
+	inicio_tmp = (int *) malloc((n_primeiro + 1) * sizeof(int));
+	grupo_tmp = (int *) malloc(coo->nnz * sizeof(int));
+	outro_tmp = (int *) malloc(coo->nnz * sizeof(int));
+	valor_tmp = (double *) malloc(coo->nnz * sizeof(double));
+	agrupa(n_primeiro, coo->nnz, primeiro, segundo, coo->valor,
+				 inicio_tmp, grupo_tmp, outro_tmp, valor_tmp);
+
+	m = nova_matriz_comprimida(coo->linhas, coo->colunas, n_segundo, coo->nnz);
+	agrupa(n_segundo, coo->nnz, outro_tmp, grupo_tmp, valor_tmp,
+				 m->inicio, NULL, m->indice, m->valor);
+
+	free(inicio_tmp);
+	free(grupo_tmp);
+	free(outro_tmp);
+	free(valor_tmp);
+	return m;
+}
+
+MatrizComprimida *coo_para_csr(MatrizCOO *coo) {
+	return coo_para_comprimida(coo, 0);
+}
+
+MatrizComprimida *coo_para_csc(MatrizCOO *coo) {
+	return coo_para_comprimida(coo, 1);
+}
+
+/* Para usar várias threads, dividimos as linhas da matriz em faixas com
+	 aproximadamente o mesmo número de valores não-nulos (e não o mesmo
+	 número de linhas, já que algumas linhas podem ser muito mais cheias que
+	 outras). A faixa t vai da linha limites[t] até limites[t+1]-1: */
+#define MAX_THREADS 64
+
+int numero_de_threads() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1) return 1;
+	if (n > MAX_THREADS) return MAX_THREADS;
+	return (int) n;
+}
+
+void divide_linhas(MatrizComprimida *A, int n_threads, int limites[]) {
+	int t;
+	int i;
+	long long alvo;
+
+	limites[0] = 0;
+	i = 0;
+	for (t = 1; t < n_threads; t++) {
+		alvo = ((long long) A->nnz * t) / n_threads;
+		while ((i < A->linhas) && (A->inicio[i] < alvo))
+			i++;
+		limites[t] = i;
+	}
+	limites[n_threads] = A->linhas;
+}
+
+/* Executa trabalho(argumentos[t]) em n_threads threads: a thread principal
+	 executa a faixa 0, e as outras faixas são executadas por novas threads.
+	 Se não for possível criar uma thread, a thread principal executa a
+	 faixa dela, para que nenhuma linha fique sem ser calculada. */
+void executa_em_paralelo(void *(*trabalho)(void *), void *argumentos,
+												 size_t tamanho_argumento, int n_threads) {
+	pthread_t threads[MAX_THREADS];
+	int criada[MAX_THREADS];
+	int t;
+
+	for (t = 1; t < n_threads; t++)
+		criada[t] = (pthread_create(&threads[t], NULL, trabalho,
+																(char *) argumentos + t * tamanho_argumento) == 0);
+	trabalho(argumentos);
+	for (t = 1; t < n_threads; t++)
+		if (criada[t]) pthread_join(threads[t], NULL);
+		else trabalho((char *) argumentos + t * tamanho_argumento);
+}
+
+/* Produto matriz-vetor (SpMV): y[i] é a soma de A[i][j] * x[j] sobre os
+	 valores não-nulos da linha i. O acesso a A é sequencial, mas o acesso a
+	 x[] segue as colunas, que podem estar em qualquer lugar de um vetor
+	 enorme. Para que o trecho de x[] usado caiba na cache, podemos percorrer
+	 as colunas em faixas de BLOCO_COLUNAS: para cada faixa, processamos a
+	 parte de cada linha que cai nela. Como as colunas de cada linha estão
+	 em ordem, basta guardar, para cada linha, onde paramos (pos[]).
+
+	 A divisão em faixas só compensa se cada linha tiver, em média, vários
+	 valores em cada faixa; caso contrário, o trabalho de retomar cada linha
+	 em cada faixa supera o ganho de cache, e usamos o laço simples. Além
+	 disso, cada faixa visita apenas as linhas que têm valores nela: cada
+	 linha fica numa lista ligada (em vetor) da faixa de sua próxima coluna,
+	 e passa para a lista de outra faixa quando a atual termina. O custo
+	 total é O(linhas + faixas + nnz). */
+#define BLOCO_COLUNAS 65536 /* 512 KB de valores double */
+#define MIN_VALORES_POR_FAIXA 4
+
+typedef struct tarefaspmv {
+	MatrizComprimida *A;
+	double *x;
+	double *y;
+	int linha_inicial;
+	int linha_final;
+} TarefaSpMV;
+
+void spmv_linhas(TarefaSpMV *t) {
+	MatrizComprimida *A = t->A;
+	int i;
+	int p;
+	double soma;
+
+	for (i = t->linha_inicial; i < t->linha_final; i++) {
+		soma = 0;
+		for (p = A->inicio[i]; p < A->inicio[i + 1]; p++)
+			soma = soma + A->valor[p] * t->x[A->indice[p]];
+		t->y[i] = soma;
+	}
+}
+
+void spmv_blocos(TarefaSpMV *t) {
+	MatrizComprimida *A = t->A;
+	int n_faixas = (A->colunas + BLOCO_COLUNAS - 1) / BLOCO_COLUNAS;
+	int *pos;
+	int *proxima_linha; /* Listas de linhas de cada faixa */
+	int *primeira_linha;
+	int i, l, f, p, fim, c1, seguinte;
+	double soma;
+
+	pos = (int *) malloc((t->linha_final - t->linha_inicial + 1) * sizeof(int));
+	proxima_linha = (int *) malloc((t->linha_final - t->linha_inicial + 1) * sizeof(int));
+	primeira_linha = (int *) malloc(n_faixas * sizeof(int));
+	for (f = 0; f < n_faixas; f++)
+		primeira_linha[f] = -1;
+	/* Insere de trás para frente, para que cada lista fique em ordem */
+	for (i = t->linha_final - 1; i >= t->linha_inicial; i--) {
+		l = i - t->linha_inicial;
+		pos[l] = A->inicio[i];
+		t->y[i] = 0;
+		if (pos[l] < A->inicio[i + 1]) {
+			f = A->indice[pos[l]] / BLOCO_COLUNAS;
+			proxima_linha[l] = primeira_linha[f];
+			primeira_linha[f] = l;
+		}
+	}
+
+	for (f = 0; f < n_faixas; f++) {
+		c1 = (f + 1) * BLOCO_COLUNAS;
+		for (l = primeira_linha[f]; l != -1; l = seguinte) {
+			seguinte = proxima_linha[l];
+			i = t->linha_inicial + l;
+			soma = 0;
+			p = pos[l];
+			fim = A->inicio[i + 1];
+			while ((p < fim) && (A->indice[p] < c1)) {
+				soma = soma + A->valor[p] * t->x[A->indice[p]];
+				p++;
+			}
+			pos[l] = p;
+			t->y[i] = t->y[i] + soma;
+			if (p < fim) { /* A linha continua numa faixa seguinte */
+				proxima_linha[l] = primeira_linha[A->indice[p] / BLOCO_COLUNAS];
+				primeira_linha[A->indice[p] / BLOCO_COLUNAS] = l;
+			}
+		}
+	}
+
+	free(pos);
+	free(proxima_linha);
+	free(primeira_linha);
+}
+
+void *spmv_faixa(void *argumento) {
+	TarefaSpMV *t = (TarefaSpMV *) argumento;
+	MatrizComprimida *A = t->A;
+	long long n_faixas = (A->colunas + BLOCO_COLUNAS - 1) / BLOCO_COLUNAS;
+	long long nnz = A->inicio[t->linha_final] - A->inicio[t->linha_inicial];
+
+	if ((n_faixas > 1) &&
+			(nnz >= n_faixas * MIN_VALORES_POR_FAIXA * (t->linha_final - t->linha_inicial)))
+		spmv_blocos(t);
+	else
+		spmv_linhas(t);
+	return NULL;
+}
+
+void spmv(MatrizComprimida *A, double x[], double y[], int n_threads) {
+	TarefaSpMV tarefas[MAX_THREADS];
+	int limites[MAX_THREADS + 1];
+	int t;
+
+	divide_linhas(A, n_threads, limites);
+	for (t = 0; t < n_threads; t++) {
+		tarefas[t].A = A;
+		tarefas[t].x = x;
+		tarefas[t].y = y;
+		tarefas[t].linha_inicial = limites[t];
+		tarefas[t].linha_final = limites[t + 1];
+	}
+	executa_em_paralelo(spmv_faixa, tarefas, sizeof(TarefaSpMV), n_threads);
+}
+
+/* Produto de matrizes esparsas (SpGEMM), pelo algoritmo de Gustavson: a
+	 linha i de C = A B é a soma das linhas k de B, cada uma multiplicada por
+	 A[i][k]. Para somar essas linhas, usamos um acumulador denso (um vetor
+	 com uma posição por coluna), um vetor de marcas que diz quais posições
+	 do acumulador estão em uso na linha atual, e a lista dessas posições.
+
+	 Como não sabemos de antemão quantos valores não-nulos C terá, o produto
+	 é feito em duas fases: a fase simbólica apenas conta os valores de cada
+	 linha de C, e a fase numérica, com C já alocada, calcula os valores. */
+typedef struct acumulador {
+	int *marca;
+	int *tocadas;
+	int n_tocadas;
+	double *valor;
+	int largura;
+	int geracao; /* Cada grupo de colunas somado usa uma marca diferente */
+} Acumulador;
+
+void inicia_acumulador(Acumulador *ac, int largura) {
+	int j;
+	ac->largura = largura;
+	ac->marca = (int *) malloc(largura * sizeof(int));
+	ac->tocadas = (int *) malloc(largura * sizeof(int));
+	ac->valor = (double *) malloc(largura * sizeof(double));
+	for (j = 0; j < largura; j++)
+		ac->marca[j] = -1;
+	ac->geracao = 0;
+	ac->n_tocadas = 0;
+}
+
+void desaloca_acumulador(Acumulador *ac) {
+	free(ac->marca);
+	free(ac->tocadas);
+	free(ac->valor);
+}
+
+/* Esvazia o acumulador em O(1), trocando de marca. Quando as marcas se
+	 esgotam, todas as posições voltam a -1 antes de recomeçar do zero. */
+void novo_grupo(Acumulador *ac) {
+	int j;
+	ac->n_tocadas = 0;
+	if (ac->geracao == INT_MAX) {
+		for (j = 0; j < ac->largura; j++)
+			ac->marca[j] = -1;
+		ac->geracao = 0;
+	} else {
+		ac->geracao++;
+	}
+}
+
+void acumula(Acumulador *ac, int j, double v) {
+	if (ac->marca[j] != ac->geracao) {
+		ac->marca[j] = ac->geracao;
+		ac->tocadas[ac->n_tocadas] = j;
+		ac->n_tocadas++;
+		ac->valor[j] = v;
+	} else {
+		ac->valor[j] = ac->valor[j] + v;
+	}
+}
+
+int compara_inteiros(const void *a, const void *b) {
+	return (*(int *) a) - (*(int *) b);
+}
+
+/* Copia as colunas acumuladas (deslocadas de c0), em ordem, para a linha
+	 de C a partir de saida; retorna a próxima posição livre */
+int descarrega(Acumulador *ac, int c0, MatrizComprimida *C, int saida) {
+	int j;
+	qsort(ac->tocadas, ac->n_tocadas, sizeof(int), compara_inteiros);
+	for (j = 0; j < ac->n_tocadas; j++) {
+		C->indice[saida] = c0 + ac->tocadas[j];
+		C->valor[saida] = ac->valor[ac->tocadas[j]];
+		saida++;
+	}
+	return saida;
+}
+
+/* Quando B tem mais de BLOCO_COLUNAS colunas, o acumulador de uma linha
+	 inteira não caberia na cache (e ocuparia muita memória por thread).
+	 Nesse caso, somamos as linhas de B por faixas de BLOCO_COLUNAS colunas.
+	 Cada linha de B usada vira um cursor, e os cursores ficam num heap de
+	 mínimo, pela coluna em que cada um está. A próxima faixa é sempre a da
+	 coluna do topo do heap, de forma que só visitamos as faixas em que a
+	 linha de C tem valores, e cada cursor é retirado do heap uma vez por
+	 faixa em que sua linha tem valores. */
+typedef struct cursor {
+	int p; /* Posição atual na linha de B */
+	int fim;
+	double multiplicador; /* O valor A[i][k] */
+} Cursor;
+
+void desce_cursor(Cursor heap[], int n, int i, MatrizComprimida *B) {
+	Cursor c = heap[i];
+	int filho;
+	while (2 * i + 1 < n) {
+		filho = 2 * i + 1;
+		if ((filho + 1 < n) && (B->indice[heap[filho + 1].p] < B->indice[heap[filho].p]))
+			filho++;
+		if (B->indice[heap[filho].p] >= B->indice[c.p]) break;
+		heap[i] = heap[filho];
+		i = filho;
+	}
+	heap[i] = c;
+}
+
+typedef struct tarefaspgemm {
+	MatrizComprimida *A;
+	MatrizComprimida *B;
+	MatrizComprimida *C;
+	int *nnz_linha; /* Usado na fase simbólica */
+	int linha_inicial;
+	int linha_final;
+} TarefaSpGEMM;
+
+void *spgemm_faixa(void *argumento) {
+	TarefaSpGEMM *t = (TarefaSpGEMM *) argumento;
+	MatrizComprimida *A = t->A;
+	MatrizComprimida *B = t->B;
+	MatrizComprimida *C = t->C; /* NULL na fase simbólica */
+	Acumulador ac;
+	Cursor *heap;
+	int n_heap, maior_linha;
+	int i, a, p, c0, c1, k;
+	int saida = 0;
+
+	if (B->colunas <= BLOCO_COLUNAS) {
+		inicia_acumulador(&ac, B->colunas);
+		for (i = t->linha_inicial; i < t->linha_final; i++) {
+			novo_grupo(&ac);
+			for (a = A->inicio[i]; a < A->inicio[i + 1]; a++) {
+				k = A->indice[a];
+				for (p = B->inicio[k]; p < B->inicio[k + 1]; p++)
+					acumula(&ac, B->indice[p], A->valor[a] * B->valor[p]);
+			}
+			if (C == NULL) t->nnz_linha[i] = ac.n_tocadas;
+			else descarrega(&ac, 0, C, C->inicio[i]);
+		}
+		desaloca_acumulador(&ac);
+		return NULL;
+	}
+
+	maior_linha = 0;
+	for (i = t->linha_inicial; i < t->linha_final; i++)
+		if (A->inicio[i + 1] - A->inicio[i] > maior_linha)
+			maior_linha = A->inicio[i + 1] - A->inicio[i];
+	heap = (Cursor *) malloc((maior_linha + 1) * sizeof(Cursor));
+	inicia_acumulador(&ac, BLOCO_COLUNAS);
+
+	for (i = t->linha_inicial; i < t->linha_final; i++) {
+		if (C != NULL) saida = C->inicio[i];
+		else t->nnz_linha[i] = 0;
+
+		n_heap = 0;
+		for (a = A->inicio[i]; a < A->inicio[i + 1]; a++) {
+			k = A->indice[a];
+			if (B->inicio[k] == B->inicio[k + 1]) continue;
+			heap[n_heap].p = B->inicio[k];
+			heap[n_heap].fim = B->inicio[k + 1];
+			heap[n_heap].multiplicador = A->valor[a];
+			n_heap++;
+		}
+		for (a = n_heap / 2 - 1; a >= 0; a--)
+			desce_cursor(heap, n_heap, a, B);
+
+		while (n_heap > 0) {
+			c0 = (B->indice[heap[0].p] / BLOCO_COLUNAS) * BLOCO_COLUNAS;
+			c1 = c0 + BLOCO_COLUNAS;
+			novo_grupo(&ac);
+			while ((n_heap > 0) && (B->indice[heap[0].p] < c1)) {
+				for (p = heap[0].p; (p < heap[0].fim) && (B->indice[p] < c1); p++)
+					acumula(&ac, B->indice[p] - c0, heap[0].multiplicador * B->valor[p]);
+				/* O cursor volta ao heap se sua linha continua em outra faixa */
+				if (p < heap[0].fim) heap[0].p = p;
+				else heap[0] = heap[--n_heap];
+				desce_cursor(heap, n_heap, 0, B);
+			}
+			if (C == NULL) t->nnz_linha[i] = t->nnz_linha[i] + ac.n_tocadas;
+			else saida = descarrega(&ac, c0, C, saida);
+		}
+	}
+
+	free(heap);
+	desaloca_acumulador(&ac);
+	return NULL;
+}
+
+/* Retorna NULL se C tiver valores demais para índices do tipo int */
+MatrizComprimida *spgemm(MatrizComprimida *A, MatrizComprimida *B, int n_threads) {
+	TarefaSpGEMM tarefas[MAX_THREADS];
+	int limites[MAX_THREADS + 1];
+	MatrizComprimida *C;
+	int *nnz_linha;
+	long long total;
+	int t;
+	int i;
+
+	divide_linhas(A, n_threads, limites);
+	nnz_linha = (int *) malloc(A->linhas * sizeof(int));
+	for (t = 0; t < n_threads; t++) {
+		tarefas[t].A = A;
+		tarefas[t].B = B;
+		tarefas[t].C = NULL;
+		tarefas[t].nnz_linha = nnz_linha;
+		tarefas[t].linha_inicial = limites[t];
+		tarefas[t].linha_final = limites[t + 1];
+	}
+
+	/* Fase simbólica */
+	executa_em_paralelo(spgemm_faixa, tarefas, sizeof(TarefaSpGEMM), n_threads);
+
+	total = 0;
+	for (i = 0; i < A->linhas; i++)
+		total = total + nnz_linha[i];
+	if (total > INT_MAX) {
+		free(nnz_linha);
+		return NULL;
+	}
+	C = nova_matriz_comprimida(A->linhas, B->colunas, A->linhas, (int) total);
+	C->inicio[0] = 0;
+	for (i = 0; i < A->linhas; i++)
+		C->inicio[i + 1] = C->inicio[i] + nnz_linha[i];
+	free(nnz_linha);
+
+	/* Fase numérica */
+	for (t = 0; t < n_threads; t++)
+		tarefas[t].C = C;
+	executa_em_paralelo(spgemm_faixa, tarefas, sizeof(TarefaSpGEMM), n_threads);
+	return C;
+}
+
+/* Para comparação, a representação por listas ligadas: um vetor com uma
+	 lista por linha, e cada nó guarda a coluna e o valor de uma posição
+	 não-nula. As listas são mantidas em ordem de coluna. */
+typedef struct noesparso {
+	int coluna;
+	double valor;
+	struct noesparso *proximo;
+} NoEsparso;
+
+typedef struct matrizligada {
+	int linhas;
+	int colunas;
+	NoEsparso **linha; /* linha[i] aponta para a lista da linha i */
+} MatrizLigada;
+
+MatrizLigada *nova_matriz_ligada(int linhas, int colunas) {
+	MatrizLigada *m;
+	int i;
+	m = (MatrizLigada *) malloc(sizeof(MatrizLigada));
+	m->linhas = linhas;
+	m->colunas = colunas;
+	m->linha = (NoEsparso **) malloc(linhas * sizeof(NoEsparso *));
+	for (i = 0; i < linhas; i++)
+		m->linha[i] = NULL;
+	return m;
+}
+
+/* Soma valor à posição (i, j), criando o nó caso ele não exista: */
+void soma_posicao(MatrizLigada *m, int i, int j, double valor) {
+	NoEsparso **ponteiro;
+	NoEsparso *novo;
+
+	ponteiro = &(m->linha[i]);
+	while (((*ponteiro) != NULL) && ((*ponteiro)->coluna < j))
+		ponteiro = &((*ponteiro)->proximo);
+
+	if (((*ponteiro) != NULL) && ((*ponteiro)->coluna == j)) {
+		(*ponteiro)->valor = (*ponteiro)->valor + valor;
+		return;
+	}
+	novo = (NoEsparso *) malloc(sizeof(NoEsparso));
+	novo->coluna = j;
+	novo->valor = valor;
+	novo->proximo = (*ponteiro);
+	(*ponteiro) = novo;
+}
+
+void spmv_ligada(MatrizLigada *A, double x[], double y[]) {
+	NoEsparso *no;
+	int i;
+
+	for (i = 0; i < A->linhas; i++) {
+		y[i] = 0;
+		for (no = A->linha[i]; no != NULL; no = no->proximo)
+			y[i] = y[i] + no->valor * x[no->coluna];
+	}
+}
+
+MatrizLigada *spgemm_ligada(MatrizLigada *A, MatrizLigada *B) {
+	MatrizLigada *C;
+	NoEsparso *a;
+	NoEsparso *b;
+	int i;
+
+	C = nova_matriz_ligada(A->linhas, B->colunas);
+	for (i = 0; i < A->linhas; i++)
+		for (a = A->linha[i]; a != NULL; a = a->proximo)
+			for (b = B->linha[a->coluna]; b != NULL; b = b->proximo)
+				soma_posicao(C, i, b->coluna, a->valor * b->valor);
+	return C;
+}
+
+void desaloca_matriz_ligada(MatrizLigada *m) {
+	NoEsparso *no;
+	NoEsparso *prox;
+	int i;
+
+	for (i = 0; i < m->linhas; i++) {
+		no = m->linha[i];
+		while (no != NULL) {
+			prox = no->proximo;
+			free(no);
+			no = prox;
+		}
+	}
+	free(m->linha);
+	free(m);
+}
+
+/* Matrizes de teste: n x n, com nnz_por_linha valores em colunas aleatórias
+	 de cada linha (as entradas do formato COO são embaralhadas) */
+MatrizCOO *matriz_aleatoria(int n, int nnz_por_linha) {
+	MatrizCOO *m;
+	int i;
+	int j;
+	int t;
+	double v;
+
+	m = (MatrizCOO *) malloc(sizeof(MatrizCOO));
+	m->linhas = n;
+	m->colunas = n;
+	m->nnz = n * nnz_por_linha;
+	m->linha = (int *) malloc(m->nnz * sizeof(int));
+	m->coluna = (int *) malloc(m->nnz * sizeof(int));
+	m->valor = (double *) malloc(m->nnz * sizeof(double));
+	for (i = 0; i < m->nnz; i++) {
+		m->linha[i] = i / nnz_por_linha;
+		m->coluna[i] = rand() % n;
+		m->valor[i] = (rand() % 100) / 10.0;
+	}
+	for (i = m->nnz - 1; i > 0; i--) {
+		j = rand() % (i + 1);
+		t = m->linha[i]; m->linha[i] = m->linha[j]; m->linha[j] = t;
+		t = m->coluna[i]; m->coluna[i] = m->coluna[j]; m->coluna[j] = t;
+		v = m->valor[i]; m->valor[i] = m->valor[j]; m->valor[j] = v;
+	}
+	return m;
+}
+
+MatrizLigada *coo_para_ligada(MatrizCOO *coo) {
+	MatrizLigada *m;
+	int i;
+	m = nova_matriz_ligada(coo->linhas, coo->colunas);
+	for (i = 0; i < coo->nnz; i++)
+		soma_posicao(m, coo->linha[i], coo->coluna[i], coo->valor[i]);
+	return m;
+}
+
+void desaloca_coo(MatrizCOO *m) {
+	free(m->linha);
+	free(m->coluna);
+	free(m->valor);
+	free(m);
+}
+
+/* Soma de todos os valores de uma matriz, usada para comparar resultados */
+double soma_comprimida(MatrizComprimida *m) {
+	double s = 0;
+	int i;
+	for (i = 0; i < m->nnz; i++)
+		s = s + m->valor[i];
+	return s;
+}
+
+double soma_ligada(MatrizLigada *m, int *nnz) {
+	NoEsparso *no;
+	double s = 0;
+	int i;
+	(*nnz) = 0;
+	for (i = 0; i < m->linhas; i++)
+		for (no = m->linha[i]; no != NULL; no = no->proximo) {
+			s = s + no->valor;
+			(*nnz)++;
+		}
+	return s;
+}
+
+#define N_SPMV 1000000
+#define NNZ_SPMV 10
+#define N_SPGEMM 100000
+#define NNZ_SPGEMM 8
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+int main() {
+	MatrizCOO *coo;
+	MatrizCOO *coo2;
+	MatrizComprimida *csr;
+	MatrizComprimida *csr2;
+	MatrizComprimida *csc;
+	MatrizComprimida *produto;
+	MatrizLigada *ligada;
+	MatrizLigada *ligada2;
+	MatrizLigada *produto_ligada;
+	double *x;
+	double *y;
+	double *y_ligada;
+	double erro;
+	struct timespec t1, t2;
+	int n_threads;
+	int nnz;
+	int i;
+
+	/* Exemplo do texto */
+	int lin[4] = {2, 0, 2, 0};
+	int col[4] = {2, 3, 1, 0};
+	double val[4] = {1, 2, 7, 5};
+	MatrizCOO exemplo = {3, 4, 4, lin, col, val};
+
+	csr = coo_para_csr(&exemplo);
+	csc = coo_para_csc(&exemplo);
+	printf("CSR: inicio =");
+	for (i = 0; i <= csr->linhas; i++) printf(" %d", csr->inicio[i]);
+	printf(", indice =");
+	for (i = 0; i < csr->nnz; i++) printf(" %d", csr->indice[i]);
+	printf(", valor =");
+	for (i = 0; i < csr->nnz; i++) printf(" %g", csr->valor[i]);
+	printf("\nCSC: inicio =");
+	for (i = 0; i <= csc->colunas; i++) printf(" %d", csc->inicio[i]);
+	printf(", indice =");
+	for (i = 0; i < csc->nnz; i++) printf(" %d", csc->indice[i]);
+	printf(", valor =");
+	for (i = 0; i < csc->nnz; i++) printf(" %g", csc->valor[i]);
+	printf("\n");
+	desaloca_matriz_comprimida(csr);
+	desaloca_matriz_comprimida(csc);
+
+	n_threads = numero_de_threads();
+	printf("---\nUsando %d threads\n", n_threads);
+	srand(1);
+
+	/* SpMV */
+	coo = matriz_aleatoria(N_SPMV, NNZ_SPMV);
+	x = (double *) malloc(N_SPMV * sizeof(double));
+	y = (double *) malloc(N_SPMV * sizeof(double));
+	y_ligada = (double *) malloc(N_SPMV * sizeof(double));
+	for (i = 0; i < N_SPMV; i++)
+		x[i] = (rand() % 100) / 10.0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	csr = coo_para_csr(coo);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("COO -> CSR (%d valores): %f segundos\n", coo->nnz, segundos(&t1, &t2));
+	ligada = coo_para_ligada(coo);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	spmv(csr, x, y, n_threads);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("SpMV CSR: %f segundos\n", segundos(&t1, &t2));
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	spmv_ligada(ligada, x, y_ligada);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("SpMV listas ligadas: %f segundos\n", segundos(&t1, &t2));
+
+	erro = 0;
+	for (i = 0; i < N_SPMV; i++)
+		if (y[i] - y_ligada[i] > erro) erro = y[i] - y_ligada[i];
+		else if (y_ligada[i] - y[i] > erro) erro = y_ligada[i] - y[i];
+	printf("Maior diferenca entre os resultados: %g\n", erro);
+
+	desaloca_matriz_comprimida(csr);
+	desaloca_matriz_ligada(ligada);
+	desaloca_coo(coo);
+	free(x);
+	free(y);
+	free(y_ligada);
+
+	/* SpGEMM */
+	coo = matriz_aleatoria(N_SPGEMM, NNZ_SPGEMM);
+	coo2 = matriz_aleatoria(N_SPGEMM, NNZ_SPGEMM);
+	csr = coo_para_csr(coo);
+	csr2 = coo_para_csr(coo2);
+	ligada = coo_para_ligada(coo);
+	ligada2 = coo_para_ligada(coo2);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	produto = spgemm(csr, csr2, n_threads);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	if (produto == NULL)
+		printf("SpGEMM CSR: o produto tem mais de %d valores\n", INT_MAX);
+	else
+		printf("SpGEMM CSR: %f segundos (%d valores, soma = %f)\n",
+					 segundos(&t1, &t2), produto->nnz, soma_comprimida(produto));
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	produto_ligada = spgemm_ligada(ligada, ligada2);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	erro = soma_ligada(produto_ligada, &nnz);
+	printf("SpGEMM listas ligadas: %f segundos (%d valores, soma = %f)\n",
+				 segundos(&t1, &t2), nnz, erro);
+
+	if (produto != NULL) desaloca_matriz_comprimida(produto);
+	desaloca_matriz_comprimida(csr);
+	desaloca_matriz_comprimida(csr2);
+	desaloca_matriz_ligada(produto_ligada);
+	desaloca_matriz_ligada(ligada);
+	desaloca_matriz_ligada(ligada2);
+	desaloca_coo(coo);
+	desaloca_coo(coo2);
+	return 0;
+}
+
+/* Para executar (a opção -pthread é necessária por causa das threads):
+	 gcc -pthread -omatrizes_esparsas 12-matrizes_esparsas.c
+	 ./matrizes_esparsas
+*/
+
+/* Exercícios
+
+	 1) Escreva uma função que calcula a transposta de uma matriz em formato
+	 CSR. Qual é a relação entre a transposta em CSR e a matriz original em
+	 CSC?
+
+	 2) Escreva uma função que soma duas matrizes em formato CSR.
+
+	 3) No formato COO, uma mesma posição pode aparecer mais de uma vez.
+	 Modifique coo_para_csr() para que valores repetidos de uma mesma posição
+	 sejam somados.
+
+	 4) Por que o tempo do SpMV em listas ligadas é tão maior que o do SpMV
+	 em CSR, se os dois fazem o mesmo número de multiplicações?
+*/
@@ -0,0 +1,342 @@
+/* Janelas deslizantes e buffers circulares
+
+	 Um problema comum ao processar uma sequência de dados (medições de um
+	 sensor, preços, pacotes de rede...) é calcular, a cada novo elemento,
+	 alguma estatística dos últimos W elementos: a soma, a média, o mínimo ou
+	 o máximo. Esse conjunto dos últimos W elementos é uma janela que desliza
+	 sobre a sequência:
+
+	 dados:   3 1 4 1 5 9 2 6
+	         [3 1 4]               soma = 8
+	           [1 4 1]             soma = 6
+	             [4 1 5]           soma = 10 ...
+
+	 Na aula sobre estruturas ligadas, sugerimos usar uma lista circular para
+	 guardar os últimos elementos. Um vetor pode fazer o mesmo papel, de forma
+	 muito mais eficiente: num buffer circular, as posições do vetor são
+	 reutilizadas em círculo, e o elemento i da sequência fica na posição
+	 i % capacidade. Se a capacidade for uma potência de 2, o resto da divisão
+	 pode ser calculado com uma operação E bit a bit:
+
+	 i % 2^k == i & (2^k - 1)
+
+	 que é bem mais rápida que uma divisão.
+
+	 A soma e a média são fáceis de manter: a cada passo, somamos o elemento
+	 que entra e subtraímos o que sai. O mínimo e o máximo são mais difíceis,
+	 já que, quando o mínimo sai da janela, precisamos saber qual é o próximo
+	 mínimo. Para isso, usamos uma fila de duas pontas monotônica, que veremos
+	 adiante.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Um buffer circular de inteiros com capacidade potência de 2. As posições
+	 são contadas desde o começo da sequência (e não reiniciadas), e a posição
+	 no vetor é obtida com a máscara: */
+typedef struct buffercircular {
+	int *dados;
+	long mascara; /* capacidade - 1 */
+	long inicio; /* Índice (na sequência) do elemento mais antigo */
+	long fim; /* Índice (na sequência) do próximo elemento a inserir */
+} BufferCircular;
+
+long potencia_de_2(long n) {
+	/* Retorna a menor potência de 2 maior ou igual a n */
+	long p = 1;
+	while (p < n)
+		p = p * 2;
+	return p;
+}
+
+int inicia_buffer(BufferCircular *b, long capacidade_minima) {
+	/* Retorna 1 em caso de sucesso e 0 caso não haja memória */
+	long capacidade = potencia_de_2(capacidade_minima);
+	b->dados = (int *) malloc(capacidade * sizeof(int));
+	if (b->dados == NULL) return 0;
+	b->mascara = capacidade - 1;
+	b->inicio = 0;
+	b->fim = 0;
+	return 1;
+}
+
+/* Com essa representação, o número de elementos é fim - inicio, e as
+	 operações nas duas pontas são O(1). Quem chama deve garantir que o
+	 buffer não fique cheio (ou vazio, ao retirar): */
+long tamanho_buffer(BufferCircular *b) {
+	return b->fim - b->inicio;
+}
+
+void insere_final(BufferCircular *b, int dado) {
+	b->dados[b->fim & b->mascara] = dado;
+	b->fim++;
+}
+
+int remove_comeco(BufferCircular *b) {
+	int dado = b->dados[b->inicio & b->mascara];
+	b->inicio++;
+	return dado;
+}
+
+int remove_final(BufferCircular *b) {
+	b->fim--;
+	return b->dados[b->fim & b->mascara];
+}
+
+int primeiro(BufferCircular *b) {
+	return b->dados[b->inicio & b->mascara];
+}
+
+int ultimo(BufferCircular *b) {
+	return b->dados[(b->fim - 1) & b->mascara];
+}
+
+/* Para o mínimo da janela, mantemos uma fila monotônica: uma fila de duas
+	 pontas com os elementos da janela que ainda podem vir a ser o mínimo,
+	 em ordem crescente. Quando um elemento x entra, todos os elementos
+	 maiores que x no final da fila são descartados - eles nunca mais serão o
+	 mínimo, pois x é menor e ficará na janela por mais tempo que eles. Assim,
+	 o primeiro elemento da fila é sempre o mínimo da janela. Quando o elemento
+	 que sai da janela é o primeiro da fila, ele também sai da fila.
+
+	 Cada elemento entra e sai da fila no máximo uma vez, então o custo é O(1)
+	 amortizado por elemento. O máximo é obtido da mesma forma, com a fila em
+	 ordem decrescente. Como elementos iguais podem estar na janela, a fila
+	 mantém os iguais (descarta apenas os estritamente maiores/menores). */
+typedef struct janela {
+	long tamanho; /* W: número de elementos da janela */
+	BufferCircular elementos; /* Os últimos W elementos */
+	BufferCircular fila_min; /* Candidatos a mínimo, em ordem crescente */
+	BufferCircular fila_max; /* Candidatos a máximo, em ordem decrescente */
+	long long soma;
+} Janela;
+
+int inicia_janela(Janela *j, long tamanho) {
+	/* Retorna 1 em caso de sucesso e 0 caso não haja memória */
+	j->tamanho = tamanho;
+	j->soma = 0;
+	if (!inicia_buffer(&(j->elementos), tamanho + 1)) return 0;
+	if (!inicia_buffer(&(j->fila_min), tamanho + 1)) return 0;
+	if (!inicia_buffer(&(j->fila_max), tamanho + 1)) return 0;
+	return 1;
+}
+
+void desaloca_janela(Janela *j) {
+	free(j->elementos.dados);
+	free(j->fila_min.dados);
+	free(j->fila_max.dados);
+}
+
+void insere_janela(Janela *j, int dado) {
+	int saindo;
+
+	if (tamanho_buffer(&(j->elementos)) == j->tamanho) {
+		saindo = remove_comeco(&(j->elementos));
+		j->soma = j->soma - saindo;
+		if (primeiro(&(j->fila_min)) == saindo) remove_comeco(&(j->fila_min));
+		if (primeiro(&(j->fila_max)) == saindo) remove_comeco(&(j->fila_max));
+	}
+
+	insere_final(&(j->elementos), dado);
+	j->soma = j->soma + dado;
+
+	while ((tamanho_buffer(&(j->fila_min)) > 0) && (ultimo(&(j->fila_min)) > dado))
+		remove_final(&(j->fila_min));
+	insere_final(&(j->fila_min), dado);
+
+	while ((tamanho_buffer(&(j->fila_max)) > 0) && (ultimo(&(j->fila_max)) < dado))
+		remove_final(&(j->fila_max));
+	insere_final(&(j->fila_max), dado);
+}
+
+/* As estatísticas consideram os elementos que já entraram, caso a janela
+	 ainda não esteja completa. A janela não pode estar vazia: */
+long long soma_janela(Janela *j) {
+	return j->soma;
+}
+
+double media_janela(Janela *j) {
+	return j->soma / (double) tamanho_buffer(&(j->elementos));
+}
+
+int minimo_janela(Janela *j) {
+	return primeiro(&(j->fila_min));
+}
+
+int maximo_janela(Janela *j) {
+	return primeiro(&(j->fila_max));
+}
+
+/* Quando toda a sequência está disponível num vetor, podemos processá-la
+	 em lote. A soma da janela terminada na posição i é a diferença entre
+	 duas somas acumuladas (prefixos):
+
+	 soma[i] = P[i] - P[i-W], onde P[i] = v[0] + ... + v[i]
+
+	 Calculamos os prefixos diretamente no vetor de saída e depois fazemos as
+	 subtrações de trás para frente (assim, P[i-W] ainda não foi modificado
+	 quando é usado). As subtrações são independentes entre si, e laços assim
+	 podem ser vetorizados pelo compilador (com -O3, o GCC usa instruções
+	 SIMD, que processam vários elementos por instrução). Para o mínimo e o
+	 máximo, o laço em lote percorre as duas filas monotônicas juntas e evita
+	 as chamadas de função e a cópia dos elementos para o buffer da janela.
+
+	 Os vetores de saída têm n posições; a posição i corresponde à janela que
+	 termina no elemento i (com menos de W elementos no começo). Os vetores
+	 media, minimo e maximo podem ser NULL, caso essas estatísticas não
+	 interessem. Retorna 1 em caso de sucesso e 0 caso não haja memória. */
+int janela_em_lote(int v[], long n, long W, long long soma[], double media[],
+									 int minimo[], int maximo[]) {
+	int *fila_min; /* Filas monotônicas circulares, como em Janela */
+	int *fila_max;
+	long mascara;
+	long ini_min, fim_min, ini_max, fim_max;
+	long long acumulado;
+	double inverso;
+	long i;
+
+	acumulado = 0;
+	for (i = 0; i < n; i++) {
+		acumulado = acumulado + v[i];
+		soma[i] = acumulado;
+	}
+	for (i = n - 1; i >= W; i--) /* Laço vetorizável */
+		soma[i] = soma[i] - soma[i - W];
+
+	if (media != NULL) {
+		for (i = 0; (i < W) && (i < n); i++)
+			media[i] = soma[i] / (double) (i + 1);
+		inverso = 1.0 / W;
+		for (i = W; i < n; i++) /* Laço vetorizável */
+			media[i] = soma[i] * inverso;
+	}
+
+	if ((minimo == NULL) && (maximo == NULL)) return 1;
+
+	mascara = potencia_de_2(W + 1) - 1;
+	fila_min = (int *) malloc((mascara + 1) * sizeof(int));
+	fila_max = (int *) malloc((mascara + 1) * sizeof(int));
+	if ((fila_min == NULL) || (fila_max == NULL)) {
+		free(fila_min);
+		free(fila_max);
+		return 0;
+	}
+
+	ini_min = fim_min = ini_max = fim_max = 0;
+	for (i = 0; i < n; i++) {
+		if (i >= W) { /* v[i-W] sai da janela */
+			if (fila_min[ini_min & mascara] == v[i - W]) ini_min++;
+			if (fila_max[ini_max & mascara] == v[i - W]) ini_max++;
+		}
+		while ((fim_min > ini_min) && (fila_min[(fim_min - 1) & mascara] > v[i])) fim_min--;
+		fila_min[fim_min & mascara] = v[i];
+		fim_min++;
+		while ((fim_max > ini_max) && (fila_max[(fim_max - 1) & mascara] < v[i])) fim_max--;
+		fila_max[fim_max & mascara] = v[i];
+		fim_max++;
+
+		if (minimo != NULL) minimo[i] = fila_min[ini_min & mascara];
+		if (maximo != NULL) maximo[i] = fila_max[ini_max & mascara];
+	}
+
+	free(fila_min);
+	free(fila_max);
+	return 1;
+}
+
+#define N_TESTE 20000000
+#define W_TESTE 1000
+
+int main() {
+	int v[10] = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+	Janela j;
+	int *dados;
+	long long *soma;
+	double *media;
+	int *minimo;
+	int *maximo;
+	long long verificacao;
+	clock_t c1, c2;
+	float t;
+	int i;
+
+	printf("Janela de 3 elementos:\n");
+	printf("dado\tsoma\tmedia\tmin\tmax\n");
+	inicia_janela(&j, 3);
+	for (i = 0; i < 10; i++) {
+		insere_janela(&j, v[i]);
+		printf("%d\t%lld\t%.2f\t%d\t%d\n", v[i], soma_janela(&j), media_janela(&j),
+					 minimo_janela(&j), maximo_janela(&j));
+	}
+	desaloca_janela(&j);
+
+	printf("---\nJanela de %d elementos sobre %d dados\n", W_TESTE, N_TESTE);
+	dados = (int *) malloc(N_TESTE * sizeof(int));
+	soma = (long long *) malloc(N_TESTE * sizeof(long long));
+	media = (double *) malloc(N_TESTE * sizeof(double));
+	minimo = (int *) malloc(N_TESTE * sizeof(int));
+	maximo = (int *) malloc(N_TESTE * sizeof(int));
+	srand(1);
+	for (i = 0; i < N_TESTE; i++) {
+		dados[i] = rand() % 1000000;
+		/* Escrever nos vetores de saída antes da medição faz com que o sistema
+			 reserve suas páginas de memória fora do tempo medido */
+		soma[i] = 0;
+		media[i] = 0;
+		minimo[i] = 0;
+		maximo[i] = 0;
+	}
+
+	verificacao = 0;
+	inicia_janela(&j, W_TESTE);
+	c1 = clock();
+	for (i = 0; i < N_TESTE; i++) {
+		insere_janela(&j, dados[i]);
+		verificacao = verificacao + soma_janela(&j) + minimo_janela(&j) + maximo_janela(&j);
+	}
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Um elemento por vez: %e elementos/s (verificacao = %lld)\n", N_TESTE/t, verificacao);
+	desaloca_janela(&j);
+
+	c1 = clock();
+	janela_em_lote(dados, N_TESTE, W_TESTE, soma, media, minimo, maximo);
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	verificacao = 0;
+	for (i = 0; i < N_TESTE; i++)
+		verificacao = verificacao + soma[i] + minimo[i] + maximo[i];
+	printf("Em lote: %e elementos/s (verificacao = %lld)\n", N_TESTE/t, verificacao);
+
+	c1 = clock();
+	janela_em_lote(dados, N_TESTE, W_TESTE, soma, NULL, NULL, NULL);
+	c2 = clock();
+	t = (c2-c1)/(float)CLOCKS_PER_SEC;
+	printf("Em lote, somente a soma: %e elementos/s\n", N_TESTE/t);
+
+	free(dados);
+	free(soma);
+	free(media);
+	free(minimo);
+	free(maximo);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O3 -ojanela_deslizante 13-janela_deslizante.c
+	 ./janela_deslizante
+*/
+
+/* Exercícios
+
+	 1) Modifique a estrutura Janela para calcular também a variância dos
+	 elementos da janela em O(1) por elemento.
+
+	 2) Por que a fila monotônica não funcionaria se descartássemos também os
+	 elementos iguais ao que está entrando? Dê um exemplo.
+
+	 3) Escreva uma função que calcula a mediana dos últimos W elementos.
+	 Qual é a complexidade por elemento da sua solução?
+*/
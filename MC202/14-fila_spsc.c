@@ -0,0 +1,451 @@
+/* Filas entre threads: produtor e consumidor
+
+	 Na aula sobre pilhas e filas, vimos que uma fila pode servir de buffer:
+	 mensagens ficam armazenadas até que possam ser processadas. Um caso muito
+	 comum é aquele em que uma thread produz mensagens (por exemplo, lendo-as
+	 da rede) e outra thread as consome. A Lista daquela aula não pode ser
+	 usada assim: se as duas threads alteram n_elementos ao mesmo tempo, uma
+	 das alterações pode se perder, e o consumidor pode ler um nó antes que o
+	 produtor termine de preenchê-lo.
+
+	 A solução mais simples seria proteger a fila com um mutex, mas, quando há
+	 exatamente um produtor e um consumidor (em inglês, single-producer
+	 single-consumer, ou SPSC), é possível fazer melhor. Usamos o buffer
+	 circular da aula anterior (capacidade fixa, potência de 2) com dois
+	 índices que só crescem:
+
+	 - final: posição onde será escrita a próxima mensagem. Somente o produtor
+	   altera final.
+	 - inicio: posição da próxima mensagem a ser lida. Somente o consumidor
+	   altera inicio.
+
+	 Como cada índice tem um único escritor, nenhuma thread precisa esperar a
+	 outra para inserir ou remover: cada operação termina em um número fixo de
+	 passos (a fila é wait-free). O cuidado necessário é com a ordem em que as
+	 escritas ficam visíveis para a outra thread. O produtor escreve a
+	 mensagem em dados[] e só depois publica o novo final com uma escrita do
+	 tipo release; o consumidor lê final com uma leitura do tipo acquire e, se
+	 vir o novo valor, tem a garantia de ver também a mensagem. Usamos os
+	 tipos atômicos de <stdatomic.h> (C11) para isso.
+
+	 Outro cuidado é com a cache. Os processadores transferem a memória entre
+	 os núcleos em linhas de 64 bytes; se inicio e final estiverem na mesma
+	 linha, cada escrita de uma thread invalida a cópia da outra, mesmo que
+	 elas nunca leiam a variável que a outra escreve (isso é chamado de false
+	 sharing). Por isso, cada índice fica em sua própria linha, junto com uma
+	 cópia local do índice da outra thread: o produtor só lê inicio quando sua
+	 cópia indica que a fila está cheia, e o consumidor só lê final quando sua
+	 cópia indica que a fila está vazia.
+*/
+
+#define _GNU_SOURCE /* Para a declaração de syscall() em unistd.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define TAMANHO_LINHA 64
+
+typedef struct filaspsc {
+	/* Linha do produtor */
+	_Alignas(TAMANHO_LINHA) atomic_ulong final;
+	unsigned long inicio_visto;
+	/* Linha do consumidor */
+	_Alignas(TAMANHO_LINHA) atomic_ulong inicio;
+	unsigned long final_visto;
+	/* Não mudam depois que a fila é criada */
+	_Alignas(TAMANHO_LINHA) unsigned long mascara;
+	int *dados;
+} FilaSPSC;
+
+/* A capacidade é arredondada para uma potência de 2 */
+void inicia_fila(FilaSPSC *f, unsigned long capacidade) {
+	unsigned long c = 1;
+	while (c < capacidade) c = 2 * c;
+	atomic_init(&(f->final), 0);
+	atomic_init(&(f->inicio), 0);
+	f->inicio_visto = 0;
+	f->final_visto = 0;
+	f->mascara = c - 1;
+	f->dados = (int *) malloc(c * sizeof(int));
+}
+
+void desaloca_fila(FilaSPSC *f) {
+	free(f->dados);
+}
+
+/* Chamada somente pelo produtor. Retorna 1 se a mensagem foi inserida e 0
+	 se a fila está cheia. */
+int fila_insere(FilaSPSC *f, int dado) {
+	unsigned long final = atomic_load_explicit(&(f->final), memory_order_relaxed);
+	if (final - f->inicio_visto > f->mascara) {
+		f->inicio_visto = atomic_load_explicit(&(f->inicio), memory_order_acquire);
+		if (final - f->inicio_visto > f->mascara) return 0;
+	}
+	f->dados[final & f->mascara] = dado;
+	atomic_store_explicit(&(f->final), final + 1, memory_order_release);
+	return 1;
+}
+
+/* Chamada somente pelo consumidor. Retorna 1 e escreve a mensagem em *dado,
+	 ou retorna 0 se a fila está vazia. Diferentemente de remove_comeco() da
+	 aula sobre filas, nenhum valor de retorno é reservado para indicar a fila
+	 vazia, de forma que -1 pode ser uma mensagem. */
+int fila_remove(FilaSPSC *f, int *dado) {
+	unsigned long inicio = atomic_load_explicit(&(f->inicio), memory_order_relaxed);
+	if (inicio == f->final_visto) {
+		f->final_visto = atomic_load_explicit(&(f->final), memory_order_acquire);
+		if (inicio == f->final_visto) return 0;
+	}
+	*dado = f->dados[inicio & f->mascara];
+	atomic_store_explicit(&(f->inicio), inicio + 1, memory_order_release);
+	return 1;
+}
+
+/* As operações em lote inserem ou removem várias mensagens com uma única
+	 publicação do índice. Como a publicação é o que faz a linha de cache
+	 mudar de núcleo, inserir 256 mensagens de uma vez custa quase o mesmo que
+	 inserir uma. As mensagens são copiadas com memcpy() em até dois trechos
+	 (antes e depois do ponto em que o buffer circular volta ao começo).
+	 Retornam o número de mensagens efetivamente inseridas ou removidas. */
+void copia_circular(int *destino, int *origem, unsigned long n, int para_fila,
+										FilaSPSC *f, unsigned long posicao) {
+	unsigned long p = posicao & f->mascara;
+	unsigned long primeiro_trecho = f->mascara + 1 - p;
+	if (primeiro_trecho > n) primeiro_trecho = n;
+	if (para_fila) {
+		memcpy(&(f->dados[p]), origem, primeiro_trecho * sizeof(int));
+		memcpy(f->dados, origem + primeiro_trecho, (n - primeiro_trecho) * sizeof(int));
+	} else {
+		memcpy(destino, &(f->dados[p]), primeiro_trecho * sizeof(int));
+		memcpy(destino + primeiro_trecho, f->dados, (n - primeiro_trecho) * sizeof(int));
+	}
+}
+
+unsigned long fila_insere_lote(FilaSPSC *f, int v[], unsigned long n) {
+	unsigned long final = atomic_load_explicit(&(f->final), memory_order_relaxed);
+	unsigned long livres = f->mascara + 1 - (final - f->inicio_visto);
+	if (livres < n) {
+		f->inicio_visto = atomic_load_explicit(&(f->inicio), memory_order_acquire);
+		livres = f->mascara + 1 - (final - f->inicio_visto);
+		if (livres < n) n = livres;
+	}
+	if (n == 0) return 0;
+	copia_circular(NULL, v, n, 1, f, final);
+	atomic_store_explicit(&(f->final), final + n, memory_order_release);
+	return n;
+}
+
+unsigned long fila_remove_lote(FilaSPSC *f, int v[], unsigned long max) {
+	unsigned long inicio = atomic_load_explicit(&(f->inicio), memory_order_relaxed);
+	unsigned long n = f->final_visto - inicio;
+	if (n < max) {
+		f->final_visto = atomic_load_explicit(&(f->final), memory_order_acquire);
+		n = f->final_visto - inicio;
+	}
+	if (n > max) n = max;
+	if (n == 0) return 0;
+	copia_circular(v, NULL, n, 0, f, inicio);
+	atomic_store_explicit(&(f->inicio), inicio + n, memory_order_release);
+	return n;
+}
+
+/* Fila bloqueante
+
+	 As funções acima retornam 0 quando não podem prosseguir, e cabe a quem
+	 as chama decidir o que fazer. Tentar de novo imediatamente (espera
+	 ocupada) dá a menor latência, mas ocupa um núcleo inteiro sem fazer nada
+	 útil - e, se houver menos núcleos que threads, impede que a outra thread
+	 rode. Por isso, a fila bloqueante tenta algumas vezes e, se não
+	 conseguir, dorme até que a outra thread a acorde.
+
+	 Para dormir, usamos o futex do Linux: futex_wait(&x, v) dorme somente se
+	 x ainda vale v, e futex_wake(&x) acorda quem está dormindo em x. Quem vai
+	 dormir lê o contador de sinais, marca que está dormindo e tenta a
+	 operação mais uma vez; quem faz progresso verifica essa marca e, se ela
+	 estiver ligada, incrementa o contador de sinais e chama futex_wake. As
+	 barreiras (atomic_thread_fence) garantem que pelo menos uma das threads
+	 vê o que a outra fez: ou a que vai dormir vê a mensagem nova, ou a que
+	 inseriu a mensagem vê a marca. Se o contador mudar entre a leitura e o
+	 futex_wait, o futex_wait retorna imediatamente. A chamada ao sistema só
+	 acontece quando alguém realmente está dormindo.
+*/
+#define N_TENTATIVAS 200
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PAUSA() __builtin_ia32_pause()
+#else
+#define PAUSA()
+#endif
+
+typedef struct filabloqueante {
+	FilaSPSC fila;
+	_Alignas(TAMANHO_LINHA) atomic_int sinal_dados; /* O consumidor dorme aqui */
+	atomic_int consumidor_dormindo;
+	_Alignas(TAMANHO_LINHA) atomic_int sinal_espaco; /* O produtor dorme aqui */
+	atomic_int produtor_dormindo;
+} FilaBloqueante;
+
+void espera_futex(atomic_int *endereco, int valor) {
+	syscall(SYS_futex, (int *) endereco, FUTEX_WAIT_PRIVATE, valor, NULL, NULL, 0);
+}
+
+void acorda_futex(atomic_int *endereco) {
+	syscall(SYS_futex, (int *) endereco, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+FilaBloqueante *nova_fila_bloqueante(unsigned long capacidade) {
+	FilaBloqueante *fb;
+	fb = (FilaBloqueante *) aligned_alloc(TAMANHO_LINHA, sizeof(FilaBloqueante));
+	inicia_fila(&(fb->fila), capacidade);
+	atomic_init(&(fb->sinal_dados), 0);
+	atomic_init(&(fb->consumidor_dormindo), 0);
+	atomic_init(&(fb->sinal_espaco), 0);
+	atomic_init(&(fb->produtor_dormindo), 0);
+	return fb;
+}
+
+void desaloca_fila_bloqueante(FilaBloqueante *fb) {
+	desaloca_fila(&(fb->fila));
+	free(fb);
+}
+
+void avisa(atomic_int *dormindo, atomic_int *sinal) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(dormindo, memory_order_relaxed)) {
+		atomic_fetch_add(sinal, 1);
+		acorda_futex(sinal);
+	}
+}
+
+/* Insere as n mensagens de v[], esperando quando a fila estiver cheia */
+void bloqueante_insere_lote(FilaBloqueante *fb, int v[], unsigned long n) {
+	unsigned long feitos, k;
+	int tentativas, sinal;
+
+	feitos = 0;
+	tentativas = 0;
+	while (feitos < n) {
+		k = fila_insere_lote(&(fb->fila), v + feitos, n - feitos);
+		if ((k == 0) && (tentativas < N_TENTATIVAS)) {
+			tentativas++;
+			PAUSA();
+			continue;
+		}
+		if (k == 0) { /* Vai dormir */
+			sinal = atomic_load(&(fb->sinal_espaco));
+			atomic_store(&(fb->produtor_dormindo), 1);
+			atomic_thread_fence(memory_order_seq_cst);
+			k = fila_insere_lote(&(fb->fila), v + feitos, n - feitos);
+			if (k == 0) espera_futex(&(fb->sinal_espaco), sinal);
+			atomic_store(&(fb->produtor_dormindo), 0);
+		}
+		if (k > 0) {
+			feitos = feitos + k;
+			tentativas = 0;
+			avisa(&(fb->consumidor_dormindo), &(fb->sinal_dados));
+		}
+	}
+}
+
+/* Remove até max mensagens, esperando até que haja pelo menos uma.
+	 Retorna o número de mensagens removidas. */
+unsigned long bloqueante_remove_lote(FilaBloqueante *fb, int v[], unsigned long max) {
+	unsigned long k;
+	int tentativas, sinal;
+
+	for (tentativas = 0; tentativas < N_TENTATIVAS; tentativas++) {
+		k = fila_remove_lote(&(fb->fila), v, max);
+		if (k > 0) {
+			avisa(&(fb->produtor_dormindo), &(fb->sinal_espaco));
+			return k;
+		}
+		PAUSA();
+	}
+	while (1) {
+		sinal = atomic_load(&(fb->sinal_dados));
+		atomic_store(&(fb->consumidor_dormindo), 1);
+		atomic_thread_fence(memory_order_seq_cst);
+		k = fila_remove_lote(&(fb->fila), v, max);
+		if (k == 0) espera_futex(&(fb->sinal_dados), sinal);
+		atomic_store(&(fb->consumidor_dormindo), 0);
+		if (k > 0) {
+			avisa(&(fb->produtor_dormindo), &(fb->sinal_espaco));
+			return k;
+		}
+	}
+}
+
+void bloqueante_insere(FilaBloqueante *fb, int dado) {
+	bloqueante_insere_lote(fb, &dado, 1);
+}
+
+int bloqueante_remove(FilaBloqueante *fb) {
+	int dado;
+	bloqueante_remove_lote(fb, &dado, 1);
+	return dado;
+}
+
+/* Testes de desempenho
+
+	 Vazão: uma thread produz N_MENSAGENS números e a thread principal os
+	 consome e soma, uma mensagem por vez ou em lotes de TAMANHO_LOTE.
+
+	 Latência: a thread principal envia um número por uma fila e espera que
+	 a outra thread o devolva por uma segunda fila (pingue-pongue). Metade do
+	 tempo de ida e volta é o tempo que uma mensagem leva para atravessar a
+	 fila. Se houver menos de dois núcleos, cada travessia inclui uma troca de
+	 contexto feita pelo sistema operacional, e os números serão bem piores. */
+#define N_MENSAGENS 20000000
+#define TAMANHO_LOTE 256
+#define CAPACIDADE_FILA 4096
+#define N_PINGUE_PONGUE 200000
+
+typedef struct argumentos {
+	FilaBloqueante *ida;
+	FilaBloqueante *volta;
+	int em_lote;
+} Argumentos;
+
+void *produtor(void *p) {
+	Argumentos *a = (Argumentos *) p;
+	int lote[TAMANHO_LOTE];
+	int i, j;
+
+	if (!a->em_lote) {
+		for (i = 0; i < N_MENSAGENS; i++)
+			bloqueante_insere(a->ida, i);
+		return NULL;
+	}
+	for (i = 0; i < N_MENSAGENS; i = i + TAMANHO_LOTE) {
+		for (j = 0; (j < TAMANHO_LOTE) && (i + j < N_MENSAGENS); j++)
+			lote[j] = i + j;
+		bloqueante_insere_lote(a->ida, lote, j);
+	}
+	return NULL;
+}
+
+void *eco(void *p) {
+	Argumentos *a = (Argumentos *) p;
+	int i;
+	for (i = 0; i < N_PINGUE_PONGUE; i++)
+		bloqueante_insere(a->volta, bloqueante_remove(a->ida));
+	return NULL;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+void teste_vazao(int em_lote) {
+	Argumentos a;
+	pthread_t thread;
+	struct timespec t1, t2;
+	int lote[TAMANHO_LOTE];
+	long long soma;
+	unsigned long recebidas, k, j;
+
+	a.ida = nova_fila_bloqueante(CAPACIDADE_FILA);
+	a.volta = NULL;
+	a.em_lote = em_lote;
+	soma = 0;
+	recebidas = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	pthread_create(&thread, NULL, produtor, &a);
+	while (recebidas < N_MENSAGENS) {
+		if (em_lote) {
+			k = bloqueante_remove_lote(a.ida, lote, TAMANHO_LOTE);
+			for (j = 0; j < k; j++) soma = soma + lote[j];
+			recebidas = recebidas + k;
+		} else {
+			soma = soma + bloqueante_remove(a.ida);
+			recebidas++;
+		}
+	}
+	pthread_join(thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	printf("%s: %e mensagens/s (soma = %lld)\n",
+				 em_lote ? "Em lotes" : "Uma por vez",
+				 N_MENSAGENS / segundos(&t1, &t2), soma);
+	desaloca_fila_bloqueante(a.ida);
+}
+
+void teste_latencia() {
+	Argumentos a;
+	pthread_t thread;
+	struct timespec t1, t2;
+	int i, erros;
+
+	a.ida = nova_fila_bloqueante(CAPACIDADE_FILA);
+	a.volta = nova_fila_bloqueante(CAPACIDADE_FILA);
+	a.em_lote = 0;
+	erros = 0;
+
+	pthread_create(&thread, NULL, eco, &a);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < N_PINGUE_PONGUE; i++) {
+		bloqueante_insere(a.ida, i);
+		if (bloqueante_remove(a.volta) != i) erros++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	pthread_join(thread, NULL);
+
+	printf("Latencia: %.1f ns por travessia (%d erros)\n",
+				 segundos(&t1, &t2) * 1e9 / (2.0 * N_PINGUE_PONGUE), erros);
+	desaloca_fila_bloqueante(a.ida);
+	desaloca_fila_bloqueante(a.volta);
+}
+
+int main() {
+	FilaSPSC f;
+	int v[6] = {10, 20, 30, 40, 50, 60};
+	int saida[6];
+	int dado;
+	unsigned long k, i;
+
+	printf("Fila de capacidade 4, usada por uma unica thread:\n");
+	inicia_fila(&f, 4);
+	k = fila_insere_lote(&f, v, 6);
+	printf("Lote de 6 mensagens: %lu inseridas\n", k);
+	fila_remove(&f, &dado);
+	printf("Removida: %d\n", dado);
+	printf("Inserir -1: %d\n", fila_insere(&f, -1));
+	printf("Inserir 70: %d\n", fila_insere(&f, 70));
+	k = fila_remove_lote(&f, saida, 6);
+	printf("Removidas em lote:");
+	for (i = 0; i < k; i++) printf(" %d", saida[i]);
+	printf("\nRemover da fila vazia: %d\n", fila_remove(&f, &dado));
+	desaloca_fila(&f);
+
+	printf("---\nDuas threads (%ld nucleos disponiveis):\n",
+				 sysconf(_SC_NPROCESSORS_ONLN));
+	teste_vazao(0);
+	teste_vazao(1);
+	teste_latencia();
+	return 0;
+}
+
+/* Para executar (a opção -pthread é necessária por causa das threads):
+	 gcc -O2 -pthread -ofila_spsc 14-fila_spsc.c
+	 ./fila_spsc
+*/
+
+/* Exercícios
+
+	 1) Por que não podemos usar esta fila com dois produtores? Descreva uma
+	 sequência de operações em que uma mensagem se perde.
+
+	 2) Troque as leituras acquire e as escritas release por leituras e
+	 escritas relaxed. O programa continua correto? Por que o erro pode não
+	 aparecer num computador com processador x86?
+
+	 3) Meça a vazão para lotes de 1, 4, 16, 64 e 256 mensagens. A partir de
+	 que tamanho o ganho deixa de ser significativo?
+*/
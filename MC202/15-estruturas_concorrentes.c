@@ -0,0 +1,497 @@
+/* Filas e pilhas com vários produtores e consumidores
+
+	 A fila da aula anterior funciona porque cada índice tem um único
+	 escritor. Quando várias threads inserem e várias threads removem
+	 (em inglês, multi-producer multi-consumer, ou MPMC), duas threads podem
+	 tentar usar a mesma posição ao mesmo tempo, e precisamos de uma forma de
+	 decidir qual delas fica com a posição.
+
+	 A forma mais simples é proteger a Lista da aula sobre pilhas e filas com
+	 um mutex: somente a thread que conseguiu travar o mutex mexe na lista.
+	 Isso é correto, mas todas as threads passam, uma de cada vez, pelo mesmo
+	 trecho de código; e, se a thread que está com o mutex for interrompida
+	 pelo sistema operacional, todas as outras ficam paradas esperando.
+
+	 Nesta aula, usamos a operação compare-and-swap (CAS):
+	 atomic_compare_exchange(&x, &esperado, novo) troca x por novo somente se
+	 x ainda vale esperado, e tudo isso acontece como uma única operação, que
+	 nenhuma outra thread consegue interromper no meio. Se outra thread mudou
+	 x antes, a operação falha, esperado recebe o valor atual de x, e tentamos
+	 de novo. Na pilha, alguma thread sempre consegue fazer progresso (ela é
+	 lock-free), mesmo que outras sejam interrompidas; na fila, veremos que
+	 há uma pequena exceção.
+
+	 Como a remoção pode falhar porque outra thread removeu o último elemento
+	 entre a verificação e a remoção, não faz sentido consultar n_elementos
+	 antes de remover. Por isso, as funções de remoção desta aula retornam 1
+	 ou 0 (sucesso ou estrutura vazia) e escrevem o dado num ponteiro, em vez
+	 de reservar o valor -1 para a lista vazia como remove_comeco() faz.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sched.h>
+
+#define TAMANHO_LINHA 64
+
+/* Referência: a Lista da aula sobre pilhas e filas, protegida por um mutex */
+typedef struct nolista {
+	int dado;
+	struct nolista *proximo;
+} NoLista;
+
+typedef struct listaprotegida {
+	pthread_mutex_t trava;
+	int n_elementos;
+	NoLista *inicio;
+	NoLista *final;
+} ListaProtegida;
+
+ListaProtegida *nova_lista_protegida() {
+	ListaProtegida *nova;
+	nova = (ListaProtegida *) malloc(sizeof(ListaProtegida));
+	pthread_mutex_init(&(nova->trava), NULL);
+	nova->n_elementos = 0;
+	nova->inicio = NULL;
+	nova->final = NULL;
+	return nova;
+}
+
+void protegida_insere_comeco(ListaProtegida *l, int dado) {
+	NoLista *novo_no;
+	novo_no = (NoLista *) malloc(sizeof(NoLista));
+	novo_no->dado = dado;
+	pthread_mutex_lock(&(l->trava));
+	novo_no->proximo = l->inicio;
+	l->inicio = novo_no;
+	if (l->n_elementos == 0) l->final = novo_no;
+	l->n_elementos = l->n_elementos + 1;
+	pthread_mutex_unlock(&(l->trava));
+}
+
+void protegida_insere_final(ListaProtegida *l, int dado) {
+	NoLista *novo_no;
+	novo_no = (NoLista *) malloc(sizeof(NoLista));
+	novo_no->dado = dado;
+	novo_no->proximo = NULL;
+	pthread_mutex_lock(&(l->trava));
+	if (l->n_elementos == 0) l->inicio = novo_no;
+	else l->final->proximo = novo_no;
+	l->final = novo_no;
+	l->n_elementos = l->n_elementos + 1;
+	pthread_mutex_unlock(&(l->trava));
+}
+
+int protegida_remove_comeco(ListaProtegida *l, int *dado) {
+	NoLista *removido;
+	pthread_mutex_lock(&(l->trava));
+	if (l->n_elementos == 0) {
+		pthread_mutex_unlock(&(l->trava));
+		return 0;
+	}
+	removido = l->inicio;
+	l->inicio = removido->proximo;
+	l->n_elementos = l->n_elementos - 1;
+	pthread_mutex_unlock(&(l->trava));
+	*dado = removido->dado;
+	free(removido);
+	return 1;
+}
+
+void desaloca_lista_protegida(ListaProtegida *l) {
+	int dado;
+	while (protegida_remove_comeco(l, &dado));
+	pthread_mutex_destroy(&(l->trava));
+	free(l);
+}
+
+/* Fila MPMC limitada
+
+	 A fila é um buffer circular de capacidade fixa (potência de 2) em que
+	 cada célula tem, além do dado, um número de sequência. Os índices final
+	 e inicio só crescem, como na aula anterior, mas agora são disputados com
+	 CAS. O número de sequência diz em que estado a célula está para a volta
+	 atual do buffer:
+
+	 - sequencia == pos: a célula está livre para a inserção na posição pos;
+	 - sequencia == pos + 1: a célula contém o dado inserido na posição pos,
+	   pronto para ser removido;
+	 - sequencia == pos + capacidade: o dado foi removido, e a célula está
+	   livre para a inserção da próxima volta.
+
+	 Para inserir, uma thread lê final e verifica a célula correspondente. Se
+	 ela está livre, tenta reservar a posição avançando final com CAS; se
+	 conseguir, a posição é só dela, e ela escreve o dado e depois publica o
+	 novo número de sequência (com uma escrita release, como na fila SPSC). Se
+	 a célula ainda guarda um dado da volta anterior, a fila está cheia. A
+	 remoção é simétrica. As threads disputam apenas o índice, e não o dado:
+	 o trabalho feito depois do CAS não bloqueia as outras threads.
+
+	 Há um detalhe: se uma thread reservou a posição p e foi interrompida
+	 antes de escrever o dado, a célula p ainda não está pronta, e a remoção
+	 retorna 0 mesmo que as posições seguintes já tenham dados. A fila não
+	 está vazia, mas o dado mais antigo ainda não chegou; quem remove deve
+	 simplesmente tentar de novo mais tarde. */
+typedef struct celula {
+	atomic_ulong sequencia;
+	int dado;
+} Celula;
+
+typedef struct filampmc {
+	_Alignas(TAMANHO_LINHA) atomic_ulong final;
+	_Alignas(TAMANHO_LINHA) atomic_ulong inicio;
+	_Alignas(TAMANHO_LINHA) unsigned long mascara;
+	Celula *celulas;
+} FilaMPMC;
+
+FilaMPMC *nova_fila_mpmc(unsigned long capacidade) {
+	FilaMPMC *f;
+	unsigned long c, i;
+
+	c = 1;
+	while (c < capacidade) c = 2 * c;
+	f = (FilaMPMC *) aligned_alloc(TAMANHO_LINHA, sizeof(FilaMPMC));
+	f->celulas = (Celula *) malloc(c * sizeof(Celula));
+	for (i = 0; i < c; i++)
+		atomic_init(&(f->celulas[i].sequencia), i);
+	f->mascara = c - 1;
+	atomic_init(&(f->final), 0);
+	atomic_init(&(f->inicio), 0);
+	return f;
+}
+
+void desaloca_fila_mpmc(FilaMPMC *f) {
+	free(f->celulas);
+	free(f);
+}
+
+/* Retorna 1 se o dado foi inserido e 0 se a fila está cheia */
+int mpmc_insere_final(FilaMPMC *f, int dado) {
+	Celula *c;
+	unsigned long pos, seq;
+	long diferenca;
+
+	pos = atomic_load_explicit(&(f->final), memory_order_relaxed);
+	while (1) {
+		c = &(f->celulas[pos & f->mascara]);
+		seq = atomic_load_explicit(&(c->sequencia), memory_order_acquire);
+		diferenca = (long) (seq - pos);
+		if (diferenca == 0) {
+			if (atomic_compare_exchange_weak_explicit(&(f->final), &pos, pos + 1,
+																								memory_order_relaxed,
+																								memory_order_relaxed))
+				break;
+		} else if (diferenca < 0) {
+			return 0;
+		} else {
+			pos = atomic_load_explicit(&(f->final), memory_order_relaxed);
+		}
+	}
+	c->dado = dado;
+	atomic_store_explicit(&(c->sequencia), pos + 1, memory_order_release);
+	return 1;
+}
+
+/* Retorna 1 e escreve o dado removido em *dado, ou 0 se a fila está vazia
+	 (ou se a inserção mais antiga ainda não terminou) */
+int mpmc_remove_comeco(FilaMPMC *f, int *dado) {
+	Celula *c;
+	unsigned long pos, seq;
+	long diferenca;
+
+	pos = atomic_load_explicit(&(f->inicio), memory_order_relaxed);
+	while (1) {
+		c = &(f->celulas[pos & f->mascara]);
+		seq = atomic_load_explicit(&(c->sequencia), memory_order_acquire);
+		diferenca = (long) (seq - (pos + 1));
+		if (diferenca == 0) {
+			if (atomic_compare_exchange_weak_explicit(&(f->inicio), &pos, pos + 1,
+																								memory_order_relaxed,
+																								memory_order_relaxed))
+				break;
+		} else if (diferenca < 0) {
+			return 0;
+		} else {
+			pos = atomic_load_explicit(&(f->inicio), memory_order_relaxed);
+		}
+	}
+	*dado = c->dado;
+	atomic_store_explicit(&(c->sequencia), pos + f->mascara + 1, memory_order_release);
+	return 1;
+}
+
+/* Pilha de Treiber
+
+	 A pilha lock-free clássica é uma lista ligada em que o topo é trocado com
+	 CAS. Para empilhar, a thread aponta o novo nó para o topo atual e tenta
+	 trocar o topo pelo novo nó; para desempilhar, lê o topo e o proximo dele
+	 e tenta trocar o topo pelo proximo.
+
+	 A remoção tem um problema sutil, chamado de problema ABA. Suponha que a
+	 thread 1 leia topo = A e A->proximo = B, e seja interrompida. A thread 2
+	 desempilha A e B e empilha A de novo. O topo volta a ser A, e o CAS da
+	 thread 1 funciona - mas coloca no topo o nó B, que já não está na pilha!
+	 O CAS compara somente o valor, e não percebe que a pilha mudou.
+
+	 A solução usada aqui é guardar, junto com o topo, um contador de
+	 versões, que é incrementado a cada alteração: o CAS da thread 1 falha,
+	 porque a versão mudou. Para que topo e versão caibam numa única palavra
+	 de 64 bits (que o CAS troca de uma vez), os nós ficam num vetor e o topo
+	 é o índice do nó (32 bits), e não um ponteiro. Os nós livres formam uma
+	 segunda pilha de Treiber, usada no lugar de malloc() e free(); assim, a
+	 pilha não aloca memória depois de criada e tem capacidade limitada,
+	 como a fila. */
+#define NULO 0xFFFFFFFFu
+
+typedef struct notreiber {
+	int dado;
+	atomic_uint proximo;
+} NoTreiber;
+
+typedef struct pilhatreiber {
+	_Alignas(TAMANHO_LINHA) atomic_ullong topo; /* Versão (32 bits) e índice (32 bits) */
+	_Alignas(TAMANHO_LINHA) atomic_ullong livres;
+	_Alignas(TAMANHO_LINHA) NoTreiber *nos;
+} PilhaTreiber;
+
+void empilha_indice(atomic_ullong *cabeca, NoTreiber *nos, unsigned int i) {
+	unsigned long long velho, novo;
+	velho = atomic_load_explicit(cabeca, memory_order_relaxed);
+	do {
+		atomic_store_explicit(&(nos[i].proximo), (unsigned int) velho, memory_order_relaxed);
+		novo = (((velho >> 32) + 1) << 32) | i;
+	} while (!atomic_compare_exchange_weak_explicit(cabeca, &velho, novo,
+																									memory_order_release,
+																									memory_order_relaxed));
+}
+
+unsigned int desempilha_indice(atomic_ullong *cabeca, NoTreiber *nos) {
+	unsigned long long velho, novo;
+	unsigned int i;
+	velho = atomic_load_explicit(cabeca, memory_order_acquire);
+	do {
+		i = (unsigned int) velho;
+		if (i == NULO) return NULO;
+		novo = (((velho >> 32) + 1) << 32) |
+			atomic_load_explicit(&(nos[i].proximo), memory_order_relaxed);
+	} while (!atomic_compare_exchange_weak_explicit(cabeca, &velho, novo,
+																									memory_order_acquire,
+																									memory_order_acquire));
+	return i;
+}
+
+PilhaTreiber *nova_pilha_treiber(unsigned int capacidade) {
+	PilhaTreiber *p;
+	unsigned int i;
+	p = (PilhaTreiber *) aligned_alloc(TAMANHO_LINHA, sizeof(PilhaTreiber));
+	p->nos = (NoTreiber *) malloc(capacidade * sizeof(NoTreiber));
+	atomic_init(&(p->topo), NULO);
+	atomic_init(&(p->livres), NULO);
+	for (i = 0; i < capacidade; i++) {
+		atomic_init(&(p->nos[i].proximo), NULO);
+		empilha_indice(&(p->livres), p->nos, i);
+	}
+	return p;
+}
+
+void desaloca_pilha_treiber(PilhaTreiber *p) {
+	free(p->nos);
+	free(p);
+}
+
+/* Retorna 1 se o dado foi empilhado e 0 se não há nós livres */
+int treiber_insere_comeco(PilhaTreiber *p, int dado) {
+	unsigned int i = desempilha_indice(&(p->livres), p->nos);
+	if (i == NULO) return 0;
+	p->nos[i].dado = dado;
+	empilha_indice(&(p->topo), p->nos, i);
+	return 1;
+}
+
+/* Retorna 1 e escreve o dado do topo em *dado, ou 0 se a pilha está vazia */
+int treiber_remove_comeco(PilhaTreiber *p, int *dado) {
+	unsigned int i = desempilha_indice(&(p->topo), p->nos);
+	if (i == NULO) return 0;
+	*dado = p->nos[i].dado;
+	empilha_indice(&(p->livres), p->nos, i);
+	return 1;
+}
+
+/* Teste de escalabilidade
+
+	 Cada thread faz N_OPERACOES/t pares de inserção e remoção. Como toda
+	 thread insere antes de remover, a estrutura nunca está vazia quando uma
+	 remoção acontece e nunca tem mais de t elementos. Ainda assim, a remoção
+	 da fila MPMC pode falhar enquanto uma inserção está pela metade; nesse
+	 caso, a thread cede o processador (sched_yield) e tenta de novo, e
+	 contamos essas repetições. A soma dos dados removidos é a mesma para
+	 todas as estruturas e serve de verificação. O
+	 número de threads vai de 1 até o dobro do número de núcleos: com mais
+	 threads que núcleos, threads são interrompidas no meio das operações, e
+	 é aí que a diferença entre o mutex e as estruturas lock-free aparece. */
+#define N_OPERACOES 8000000
+#define CAPACIDADE 1024
+#define MAX_THREADS 256
+
+enum { FILA_MUTEX, FILA_MPMC, PILHA_MUTEX, PILHA_TREIBER };
+const char *nomes[] = {"Fila com mutex", "Fila MPMC", "Pilha com mutex",
+											 "Pilha de Treiber"};
+
+typedef struct argumentos {
+	int estrutura;
+	int n_pares;
+	int thread;
+	void *dados;
+	long long soma;
+	int repeticoes;
+} Argumentos;
+
+void *trabalho(void *p) {
+	Argumentos *a = (Argumentos *) p;
+	int i, valor, dado;
+
+	a->soma = 0;
+	a->repeticoes = 0;
+	for (i = 0; i < a->n_pares; i++) {
+		valor = a->thread * a->n_pares + i;
+		switch (a->estrutura) {
+		case FILA_MUTEX:
+			protegida_insere_final((ListaProtegida *) a->dados, valor);
+			while (!protegida_remove_comeco((ListaProtegida *) a->dados, &dado)) {
+				a->repeticoes++;
+				sched_yield();
+			}
+			break;
+		case FILA_MPMC:
+			while (!mpmc_insere_final((FilaMPMC *) a->dados, valor)) {
+				a->repeticoes++;
+				sched_yield();
+			}
+			while (!mpmc_remove_comeco((FilaMPMC *) a->dados, &dado)) {
+				a->repeticoes++;
+				sched_yield();
+			}
+			break;
+		case PILHA_MUTEX:
+			protegida_insere_comeco((ListaProtegida *) a->dados, valor);
+			while (!protegida_remove_comeco((ListaProtegida *) a->dados, &dado)) {
+				a->repeticoes++;
+				sched_yield();
+			}
+			break;
+		default:
+			while (!treiber_insere_comeco((PilhaTreiber *) a->dados, valor)) {
+				a->repeticoes++;
+				sched_yield();
+			}
+			while (!treiber_remove_comeco((PilhaTreiber *) a->dados, &dado)) {
+				a->repeticoes++;
+				sched_yield();
+			}
+		}
+		a->soma = a->soma + dado;
+	}
+	return NULL;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+void teste_escalabilidade(int estrutura, int n_threads) {
+	pthread_t threads[MAX_THREADS];
+	Argumentos a[MAX_THREADS];
+	struct timespec t1, t2;
+	void *dados;
+	long long soma;
+	int t, repeticoes;
+
+	if ((estrutura == FILA_MUTEX) || (estrutura == PILHA_MUTEX))
+		dados = nova_lista_protegida();
+	else if (estrutura == FILA_MPMC)
+		dados = nova_fila_mpmc(CAPACIDADE);
+	else
+		dados = nova_pilha_treiber(CAPACIDADE);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (t = 0; t < n_threads; t++) {
+		a[t].estrutura = estrutura;
+		a[t].n_pares = N_OPERACOES / n_threads;
+		a[t].thread = t;
+		a[t].dados = dados;
+		pthread_create(&threads[t], NULL, trabalho, &a[t]);
+	}
+	soma = 0;
+	repeticoes = 0;
+	for (t = 0; t < n_threads; t++) {
+		pthread_join(threads[t], NULL);
+		soma = soma + a[t].soma;
+		repeticoes = repeticoes + a[t].repeticoes;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	printf("%s, %d threads: %e operacoes/s (soma = %lld, repeticoes = %d)\n",
+				 nomes[estrutura], n_threads,
+				 2.0 * a[0].n_pares * n_threads / segundos(&t1, &t2), soma, repeticoes);
+
+	if ((estrutura == FILA_MUTEX) || (estrutura == PILHA_MUTEX))
+		desaloca_lista_protegida((ListaProtegida *) dados);
+	else if (estrutura == FILA_MPMC)
+		desaloca_fila_mpmc((FilaMPMC *) dados);
+	else
+		desaloca_pilha_treiber((PilhaTreiber *) dados);
+}
+
+int main() {
+	FilaMPMC *fila;
+	PilhaTreiber *pilha;
+	int dado, i, n_nucleos, estrutura, t;
+
+	printf("Inserindo e retirando numeros na ordem em:\nFILA\tPILHA\n");
+	fila = nova_fila_mpmc(8);
+	pilha = nova_pilha_treiber(8);
+	for (i = 0; i < 5; i++) {
+		mpmc_insere_final(fila, i);
+		treiber_insere_comeco(pilha, i);
+	}
+	for (i = 0; i < 5; i++) {
+		mpmc_remove_comeco(fila, &dado);
+		printf("%d\t", dado);
+		treiber_remove_comeco(pilha, &dado);
+		printf("%d\n", dado);
+	}
+	printf("Remover da fila vazia: %d\n", mpmc_remove_comeco(fila, &dado));
+	desaloca_fila_mpmc(fila);
+	desaloca_pilha_treiber(pilha);
+
+	n_nucleos = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (n_nucleos < 1) n_nucleos = 1;
+	if (2 * n_nucleos > MAX_THREADS) n_nucleos = MAX_THREADS / 2;
+	printf("---\n%d nucleos disponiveis\n", n_nucleos);
+	for (estrutura = FILA_MUTEX; estrutura <= PILHA_TREIBER; estrutura++)
+		for (t = 1; t <= 2 * n_nucleos; t = 2 * t)
+			teste_escalabilidade(estrutura, t);
+	return 0;
+}
+
+/* Para executar (a opção -pthread é necessária por causa das threads):
+	 gcc -O2 -pthread -oestruturas_concorrentes 15-estruturas_concorrentes.c
+	 ./estruturas_concorrentes
+*/
+
+/* Exercícios
+
+	 1) Com 32 bits de versão, o problema ABA ainda pode acontecer? Quantas
+	 operações precisariam acontecer enquanto uma thread está interrompida?
+
+	 2) Na pilha de Treiber, por que não podemos devolver o nó removido com
+	 free() e alocar nós novos com malloc()? (Dica: o que acontece se uma
+	 thread ler nos[i].proximo depois que o nó foi liberado?)
+
+	 3) Meça o desempenho das estruturas quando metade das threads somente
+	 insere e a outra metade somente remove. O que muda?
+*/
@@ -0,0 +1,489 @@
+/* Fibonacci: da recursão ao cálculo em O(log N)
+
+	 Na aula sobre pilhas e filas, calculamos fibonacci(N) simulando a
+	 recursão com uma pilha explícita: cada chamada empilha duas outras. O
+	 número de elementos que passam pela pilha é proporcional ao próprio
+	 fibonacci(N), que cresce exponencialmente (fibonacci(40) já exige mais
+	 de 10^8 empilhamentos). O problema não é a pilha, e sim o algoritmo: os
+	 mesmos valores são calculados muitas e muitas vezes.
+
+	 Nesta aula, veremos formas melhores de calcular a sequência:
+
+	 - Iterativa: guardamos somente os dois últimos valores e avançamos N
+	   vezes. Custo O(N).
+	 - Memorizada: guardamos numa tabela todos os valores já calculados.
+	   Depois que a tabela está pronta, cada consulta custa O(1).
+	 - Por potência de matriz: vale a identidade
+
+	     | 1 1 |^N   | F(N+1) F(N)   |
+	     | 1 0 |   = | F(N)   F(N-1) |
+
+	   e a potência pode ser calculada com O(log N) multiplicações, elevando
+	   a matriz ao quadrado repetidamente (como em x^8 = ((x^2)^2)^2).
+	 - Por duplicação (fast doubling): da identidade acima, tiramos
+
+	     F(2k)   = F(k) * (2 F(k+1) - F(k))
+	     F(2k+1) = F(k)^2 + F(k+1)^2
+
+	   que também leva a O(log N) passos, mas com menos multiplicações que a
+	   versão matricial.
+
+	 Com inteiros de 64 bits, só conseguimos representar até F(93). Para N
+	 maiores, usamos números de precisão arbitrária, guardados num vetor de
+	 "dígitos" na base 10^9 (cada dígito é um unsigned int). Com eles, o custo
+	 das operações passa a depender do tamanho dos números: somar dois números
+	 de d dígitos custa O(d) e multiplicá-los (pelo algoritmo da escola)
+	 custa O(d^2). Como F(N) tem cerca de 0,21 N dígitos decimais, a versão
+	 iterativa custa O(N^2), e a de duplicação é dominada pelas últimas
+	 multiplicações, também O(N^2) no pior caso, mas com uma constante muito
+	 menor. O teste de desempenho mostra a partir de que N cada versão vale
+	 a pena.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef unsigned long long u64;
+
+#define MAX_FIB_64 93 /* F(93) é o maior valor que cabe em 64 bits */
+
+/* Versão recursiva, para comparação: custo exponencial */
+u64 fib_recursiva(int n) {
+	if (n < 3) return (n > 0);
+	return fib_recursiva(n - 1) + fib_recursiva(n - 2);
+}
+
+u64 fib_iterativa(int n) {
+	u64 a = 0, b = 1, c; /* a = F(i), b = F(i+1) */
+	int i;
+	for (i = 0; i < n; i++) {
+		c = a + b;
+		a = b;
+		b = c;
+	}
+	return a;
+}
+
+/* A tabela é estendida somente até o maior N já pedido. Ela tem espaço
+	 apenas para F(0) a F(MAX_FIB_64): as outras versões calculariam um
+	 valor errado (com estouro) para N maiores, mas esta escreveria fora da
+	 tabela. Por isso, para N fora desse intervalo, retorna 0. */
+u64 tabela_fib[MAX_FIB_64 + 1] = {0, 1};
+int n_tabela = 2;
+
+u64 fib_memorizada(int n) {
+	if ((n < 0) || (n > MAX_FIB_64)) return 0;
+	while (n_tabela <= n) {
+		tabela_fib[n_tabela] = tabela_fib[n_tabela - 1] + tabela_fib[n_tabela - 2];
+		n_tabela++;
+	}
+	return tabela_fib[n];
+}
+
+/* Matrizes 2x2 simétricas: m[0] m[1] / m[1] m[2] */
+void multiplica_matriz(u64 a[3], u64 b[3], u64 resultado[3]) {
+	u64 r[3];
+	r[0] = a[0] * b[0] + a[1] * b[1];
+	r[1] = a[0] * b[1] + a[1] * b[2];
+	r[2] = a[1] * b[1] + a[2] * b[2];
+	resultado[0] = r[0];
+	resultado[1] = r[1];
+	resultado[2] = r[2];
+}
+
+u64 fib_matriz(int n) {
+	u64 resultado[3] = {1, 0, 1}; /* Identidade */
+	u64 potencia[3] = {1, 1, 0};
+	while (n > 0) {
+		if (n & 1) multiplica_matriz(resultado, potencia, resultado);
+		multiplica_matriz(potencia, potencia, potencia);
+		n = n >> 1;
+	}
+	return resultado[1];
+}
+
+/* Percorremos os bits de n do mais significativo para o menos
+	 significativo, mantendo a = F(k) e b = F(k+1), onde k é o número formado
+	 pelos bits já lidos. Cada bit dobra k (e soma 1 se o bit for 1). */
+u64 fib_duplicacao(int n) {
+	u64 a = 0, b = 1, c, d;
+	int bit;
+	for (bit = 30; (bit >= 0) && (((n >> bit) & 1) == 0); bit--); /* Zeros à esquerda */
+	for (; bit >= 0; bit--) {
+		c = a * (2 * b - a); /* F(2k) */
+		d = a * a + b * b;   /* F(2k+1) */
+		if ((n >> bit) & 1) {
+			a = d;
+			b = c + d;
+		} else {
+			a = c;
+			b = d;
+		}
+	}
+	return a;
+}
+
+/* Números de precisão arbitrária */
+#define BASE 1000000000u
+
+typedef struct numerogrande {
+	int n_digitos; /* Dígitos na base 10^9, do menos para o mais significativo */
+	int capacidade;
+	unsigned int *digitos;
+} NumeroGrande;
+
+void inicia_numero(NumeroGrande *x, unsigned int valor) {
+	x->capacidade = 4;
+	x->digitos = (unsigned int *) malloc(x->capacidade * sizeof(unsigned int));
+	x->digitos[0] = valor % BASE;
+	x->digitos[1] = valor / BASE;
+	x->n_digitos = (x->digitos[1] > 0) ? 2 : 1;
+}
+
+void desaloca_numero(NumeroGrande *x) {
+	free(x->digitos);
+}
+
+void garante_capacidade(NumeroGrande *x, int n) {
+	if (x->capacidade >= n) return;
+	while (x->capacidade < n) x->capacidade = 2 * x->capacidade;
+	x->digitos = (unsigned int *) realloc(x->digitos, x->capacidade * sizeof(unsigned int));
+}
+
+void remove_zeros(NumeroGrande *x) {
+	while ((x->n_digitos > 1) && (x->digitos[x->n_digitos - 1] == 0))
+		x->n_digitos--;
+}
+
+void copia_numero(NumeroGrande *origem, NumeroGrande *destino) {
+	garante_capacidade(destino, origem->n_digitos);
+	memcpy(destino->digitos, origem->digitos, origem->n_digitos * sizeof(unsigned int));
+	destino->n_digitos = origem->n_digitos;
+}
+
+/* resultado = a + b (resultado pode ser o próprio a ou b) */
+void soma_numeros(NumeroGrande *a, NumeroGrande *b, NumeroGrande *resultado) {
+	int i, n;
+	unsigned int vai_um, s;
+
+	n = (a->n_digitos > b->n_digitos) ? a->n_digitos : b->n_digitos;
+	garante_capacidade(resultado, n + 1);
+	vai_um = 0;
+	for (i = 0; i < n; i++) {
+		s = vai_um;
+		if (i < a->n_digitos) s = s + a->digitos[i];
+		if (i < b->n_digitos) s = s + b->digitos[i];
+		vai_um = (s >= BASE);
+		resultado->digitos[i] = vai_um ? s - BASE : s;
+	}
+	resultado->digitos[n] = vai_um;
+	resultado->n_digitos = n + vai_um;
+}
+
+/* resultado = a - b, supondo a >= b (resultado pode ser o próprio a) */
+void subtrai_numeros(NumeroGrande *a, NumeroGrande *b, NumeroGrande *resultado) {
+	int i;
+	long long d, empresta;
+
+	garante_capacidade(resultado, a->n_digitos);
+	empresta = 0;
+	for (i = 0; i < a->n_digitos; i++) {
+		d = (long long) a->digitos[i] - empresta;
+		if (i < b->n_digitos) d = d - b->digitos[i];
+		empresta = (d < 0);
+		resultado->digitos[i] = (unsigned int) (empresta ? d + BASE : d);
+	}
+	resultado->n_digitos = a->n_digitos;
+	remove_zeros(resultado);
+}
+
+/* resultado = a * b (resultado deve ser diferente de a e de b) */
+void multiplica_numeros(NumeroGrande *a, NumeroGrande *b, NumeroGrande *resultado) {
+	int i, j, n;
+	u64 atual, vai;
+
+	n = a->n_digitos + b->n_digitos;
+	garante_capacidade(resultado, n);
+	memset(resultado->digitos, 0, n * sizeof(unsigned int));
+	for (i = 0; i < a->n_digitos; i++) {
+		vai = 0;
+		for (j = 0; j < b->n_digitos; j++) {
+			atual = resultado->digitos[i + j] + (u64) a->digitos[i] * b->digitos[j] + vai;
+			resultado->digitos[i + j] = (unsigned int) (atual % BASE);
+			vai = atual / BASE;
+		}
+		resultado->digitos[i + b->n_digitos] = (unsigned int) vai;
+	}
+	resultado->n_digitos = n;
+	remove_zeros(resultado);
+}
+
+void imprime_numero(NumeroGrande *x) {
+	int i;
+	printf("%u", x->digitos[x->n_digitos - 1]);
+	for (i = x->n_digitos - 2; i >= 0; i--)
+		printf("%09u", x->digitos[i]);
+}
+
+/* Número de dígitos decimais, usado para verificar os resultados grandes */
+int digitos_decimais(NumeroGrande *x) {
+	int d = 9 * (x->n_digitos - 1);
+	unsigned int primeiro = x->digitos[x->n_digitos - 1];
+	do {
+		d++;
+		primeiro = primeiro / 10;
+	} while (primeiro > 0);
+	return d;
+}
+
+/* Escreve F(n) em resultado, que deve ter sido iniciado. A cada passo,
+	 c = a + b, e os três números trocam de papel (trocar as estruturas
+	 copia somente os ponteiros, e não os dígitos). */
+void avanca(NumeroGrande *a, NumeroGrande *b, NumeroGrande *c) {
+	NumeroGrande t;
+	soma_numeros(a, b, c);
+	t = *a;
+	*a = *b;
+	*b = *c;
+	*c = t;
+}
+
+void fib_grande_iterativa(int n, NumeroGrande *resultado) {
+	NumeroGrande a, b, c; /* a = F(i), b = F(i+1) */
+	int i;
+
+	inicia_numero(&a, 0);
+	inicia_numero(&b, 1);
+	inicia_numero(&c, 0);
+	for (i = 0; i < n; i++)
+		avanca(&a, &b, &c);
+	copia_numero(&a, resultado);
+	desaloca_numero(&a);
+	desaloca_numero(&b);
+	desaloca_numero(&c);
+}
+
+void fib_grande_duplicacao(int n, NumeroGrande *resultado) {
+	NumeroGrande a, b, c, d, t;
+	int bit;
+
+	inicia_numero(&a, 0);
+	inicia_numero(&b, 1);
+	inicia_numero(&c, 0);
+	inicia_numero(&d, 0);
+	inicia_numero(&t, 0);
+	for (bit = 30; (bit >= 0) && (((n >> bit) & 1) == 0); bit--);
+	for (; bit >= 0; bit--) {
+		soma_numeros(&b, &b, &t);         /* t = 2 F(k+1) */
+		subtrai_numeros(&t, &a, &t);      /* t = 2 F(k+1) - F(k) */
+		multiplica_numeros(&a, &t, &c);   /* c = F(2k) */
+		multiplica_numeros(&a, &a, &t);   /* t = F(k)^2 */
+		multiplica_numeros(&b, &b, &d);   /* d = F(k+1)^2 */
+		soma_numeros(&d, &t, &d);         /* d = F(2k+1) */
+		if ((n >> bit) & 1) {
+			copia_numero(&d, &a);
+			soma_numeros(&c, &d, &b);
+		} else {
+			copia_numero(&c, &a);
+			copia_numero(&d, &b);
+		}
+	}
+	copia_numero(&a, resultado);
+	desaloca_numero(&a);
+	desaloca_numero(&b);
+	desaloca_numero(&c);
+	desaloca_numero(&d);
+	desaloca_numero(&t);
+}
+
+/* Cálculo em lote: quando precisamos de F(n) para muitos valores de n,
+	 não vale a pena calcular cada um separadamente. Ordenamos os pedidos
+	 (guardando a posição original de cada um) e percorremos a sequência uma
+	 única vez, até o maior n pedido, copiando cada valor quando passamos
+	 por ele. O custo é o de um único cálculo iterativo, mais as cópias. */
+typedef struct pedido {
+	int n;
+	int posicao;
+} Pedido;
+
+int compara_pedidos(const void *p1, const void *p2) {
+	return ((Pedido *) p1)->n - ((Pedido *) p2)->n;
+}
+
+/* resultados[i] recebe F(ns[i]); os resultados devem ter sido iniciados */
+void fib_grande_lote(int ns[], int k, NumeroGrande resultados[]) {
+	Pedido *pedidos;
+	NumeroGrande a, b, c; /* a = F(i), b = F(i+1) */
+	int i, j;
+
+	pedidos = (Pedido *) malloc(k * sizeof(Pedido));
+	for (j = 0; j < k; j++) {
+		pedidos[j].n = ns[j];
+		pedidos[j].posicao = j;
+	}
+	qsort(pedidos, k, sizeof(Pedido), compara_pedidos);
+
+	inicia_numero(&a, 0);
+	inicia_numero(&b, 1);
+	inicia_numero(&c, 0);
+	i = 0;
+	for (j = 0; j < k; j++) {
+		while (i < pedidos[j].n) {
+			avanca(&a, &b, &c);
+			i++;
+		}
+		copia_numero(&a, &resultados[pedidos[j].posicao]);
+	}
+
+	desaloca_numero(&a);
+	desaloca_numero(&b);
+	desaloca_numero(&c);
+	free(pedidos);
+}
+
+/* Testes de desempenho
+
+	 Com 64 bits, N não passa de 93, e todas as versões, exceto a recursiva,
+	 levam algumas dezenas de nanossegundos; a memorizada, que só lê a
+	 tabela, é a mais rápida, e as versões O(log N) só superam a iterativa
+	 perto do fim do intervalo. As diferenças importantes aparecem com
+	 precisão arbitrária. */
+#define REPETICOES 1000000
+#define N_LOTE 1000
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+/* Tempo médio, em nanossegundos, de uma chamada de f(n) */
+double mede_64(u64 (*f)(int), int n, int repeticoes, u64 *verificacao) {
+	struct timespec t1, t2;
+	u64 soma = 0;
+	int i;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < repeticoes; i++)
+		soma = soma + f(n + (i & 1)); /* Alterna n e n+1 para que a chamada não
+																		 seja eliminada pelo compilador */
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	*verificacao = soma;
+	return segundos(&t1, &t2) * 1e9 / repeticoes;
+}
+
+double mede_grande(void (*f)(int, NumeroGrande *), int n, NumeroGrande *resultado) {
+	struct timespec t1, t2;
+	int i, repeticoes;
+	repeticoes = (n <= 1000) ? 1000 : (n <= 10000) ? 10 : 1;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < repeticoes; i++)
+		f(n, resultado);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	return segundos(&t1, &t2) * 1e6 / repeticoes;
+}
+
+int main() {
+	int ns_64[] = {5, 10, 20, 30, 40, 60, 92};
+	int ns_grandes[] = {10, 100, 1000, 10000, 100000};
+	int ns_lote[N_LOTE];
+	NumeroGrande x, y, lote[N_LOTE];
+	u64 v1, v2, v3, v4, v5;
+	double t_iterativa, t_duplicacao, t_lote;
+	struct timespec t1, t2;
+	int i, j, n, erros;
+
+	printf("F(1) a F(10):");
+	for (i = 1; i <= 10; i++) printf(" %llu", fib_duplicacao(i));
+	printf("\nF(93) = %llu\n", fib_memorizada(93));
+	inicia_numero(&x, 0);
+	fib_grande_duplicacao(300, &x);
+	printf("F(300) = ");
+	imprime_numero(&x);
+	printf("\n");
+
+	erros = 0;
+	for (i = 0; i <= MAX_FIB_64; i++)
+		if ((fib_iterativa(i) != fib_memorizada(i)) || (fib_matriz(i) != fib_memorizada(i)) ||
+				(fib_duplicacao(i) != fib_memorizada(i)))
+			erros++;
+	inicia_numero(&y, 0);
+	for (i = 0; i <= 2000; i = i + 7) {
+		fib_grande_iterativa(i, &x);
+		fib_grande_duplicacao(i, &y);
+		subtrai_numeros(&x, &y, &y);
+		if ((y.n_digitos != 1) || (y.digitos[0] != 0)) erros++;
+	}
+	printf("Erros entre as versoes: %d\n", erros);
+
+	printf("---\nInteiros de 64 bits, nanossegundos por chamada:\n");
+	printf("N\trecursiva\titerativa\tmatriz\tduplicacao\tmemorizada\n");
+	for (j = 0; j < 7; j++) {
+		n = ns_64[j];
+		if (n <= 30)
+			printf("%d\t%.1f", n, mede_64(fib_recursiva, n, (n <= 20) ? REPETICOES / 100 : 10, &v1));
+		else
+			printf("%d\t-", n);
+		printf("\t\t%.1f", mede_64(fib_iterativa, n, REPETICOES, &v2));
+		printf("\t\t%.1f", mede_64(fib_matriz, n, REPETICOES, &v3));
+		printf("\t%.1f", mede_64(fib_duplicacao, n, REPETICOES, &v4));
+		printf("\t\t%.1f\n", mede_64(fib_memorizada, n, REPETICOES, &v5));
+		if ((v2 != v3) || (v3 != v4) || (v4 != v5)) printf("Resultados diferentes!\n");
+	}
+
+	printf("---\nPrecisao arbitraria, microssegundos por chamada:\n");
+	printf("N\tdigitos\titerativa\tduplicacao\n");
+	for (j = 0; j < 5; j++) {
+		n = ns_grandes[j];
+		t_iterativa = mede_grande(fib_grande_iterativa, n, &x);
+		t_duplicacao = mede_grande(fib_grande_duplicacao, n, &y);
+		subtrai_numeros(&x, &y, &y);
+		printf("%d\t%d\t%.1f\t\t%.1f%s\n", n, digitos_decimais(&x), t_iterativa,
+					 t_duplicacao, ((y.n_digitos == 1) && (y.digitos[0] == 0)) ? "" : " (erro)");
+	}
+
+	/* N_LOTE pedidos aleatórios entre 0 e 20000 */
+	srand(1);
+	for (i = 0; i < N_LOTE; i++) {
+		ns_lote[i] = rand() % 20001;
+		inicia_numero(&lote[i], 0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fib_grande_lote(ns_lote, N_LOTE, lote);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	t_lote = segundos(&t1, &t2);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < N_LOTE; i++)
+		fib_grande_duplicacao(ns_lote[i], &x);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	erros = 0;
+	for (i = 0; i < N_LOTE; i = i + 50) {
+		fib_grande_duplicacao(ns_lote[i], &x);
+		subtrai_numeros(&x, &lote[i], &y);
+		if ((y.n_digitos != 1) || (y.digitos[0] != 0)) erros++;
+	}
+	printf("---\n%d pedidos ate N = 20000: em lote %f s, por duplicacao %f s (erros: %d)\n",
+				 N_LOTE, t_lote, segundos(&t1, &t2), erros);
+
+	for (i = 0; i < N_LOTE; i++) desaloca_numero(&lote[i]);
+	desaloca_numero(&x);
+	desaloca_numero(&y);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -ofibonacci 16-fibonacci.c
+	 ./fibonacci
+*/
+
+/* Exercícios
+
+	 1) Quantos elementos passam pela pilha na função fibonacci(N) da aula
+	 sobre pilhas e filas? Escreva a recorrência e compare com F(N).
+
+	 2) Modifique fib_duplicacao() para calcular F(N) módulo um número M,
+	 para N de até 10^18.
+
+	 3) A multiplicação de números grandes da escola custa O(d^2). Pesquise o
+	 algoritmo de Karatsuba e estime a partir de quantos dígitos ele passaria
+	 a compensar nesta implementação.
+*/
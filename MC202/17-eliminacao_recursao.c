@@ -0,0 +1,571 @@
+/* Eliminação de recursão com pilhas de quadros
+
+	 Na aula sobre pilhas e filas, eliminamos a recursão de fatorial() e de
+	 fibonacci() empilhando inteiros numa Lista. Isso funcionou porque cada
+	 chamada dessas funções só precisa guardar um número, e porque nada
+	 precisa ser feito depois que as chamadas "filhas" terminam. Em algoritmos
+	 reais, uma chamada guarda várias variáveis e continua a executar depois
+	 de cada chamada recursiva: o percurso em inordem visita o nó depois de
+	 percorrer o filho esquerdo, o quicksort ordena a metade direita depois
+	 da esquerda, e assim por diante.
+
+	 Para simular isso, fazemos o que o próprio compilador faz. Cada chamada
+	 tem um quadro (em inglês, frame): uma estrutura com os parâmetros, as
+	 variáveis locais e um campo estado, que diz em que ponto da função a
+	 execução deve continuar quando a chamada voltar ao topo da pilha. A
+	 função recursiva vira um laço com um switch sobre o estado do quadro do
+	 topo:
+
+	 - estado 0: começo da função;
+	 - antes de cada chamada recursiva, gravamos no quadro o estado de
+	   retorno e empilhamos o quadro da chamada;
+	 - ao terminar, desempilhamos o quadro, e o laço continua no quadro de
+	   baixo, no estado que ele gravou.
+
+	 Os quadros ficam lado a lado num único vetor (uma arena) que cresce com
+	 realloc() quando necessário. Assim, empilhar e desempilhar são somas e
+	 subtrações de um índice, sem nenhum malloc() por chamada, e a profundidade
+	 máxima é limitada pela memória do computador, e não pelo tamanho da pilha
+	 de execução (tipicamente 8 MB no Linux).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+typedef struct pilhaquadros {
+	char *memoria;
+	size_t topo; /* Bytes ocupados */
+	size_t capacidade;
+	size_t maximo; /* Maior valor já atingido por topo */
+	long retorno; /* Valor de retorno da última chamada que terminou */
+} PilhaQuadros;
+
+void inicia_pilha_quadros(PilhaQuadros *p) {
+	p->capacidade = 4096;
+	p->memoria = (char *) malloc(p->capacidade);
+	p->topo = 0;
+	p->maximo = 0;
+	p->retorno = 0;
+}
+
+void desaloca_pilha_quadros(PilhaQuadros *p) {
+	free(p->memoria);
+}
+
+/* Os tamanhos são arredondados para múltiplos de 8 bytes, para que todos
+	 os quadros fiquem alinhados */
+#define ALINHA(tamanho) (((tamanho) + 7) & ~((size_t) 7))
+
+/* Reserva um quadro no topo e retorna seu endereço, ou NULL caso não haja
+	 memória. Cuidado: se a arena crescer, ela pode mudar de lugar, e os
+	 ponteiros para quadros obtidos antes deixam de valer. Por isso, depois de
+	 empilhar, o ponteiro para o quadro de baixo não deve mais ser usado;
+	 quando a execução voltar a ele, pegamos o topo de novo. */
+void *empilha_quadro(PilhaQuadros *p, size_t tamanho) {
+	char *nova;
+	tamanho = ALINHA(tamanho);
+	if (p->topo + tamanho > p->capacidade) {
+		nova = (char *) realloc(p->memoria, 2 * p->capacidade + tamanho);
+		if (nova == NULL) return NULL;
+		p->memoria = nova;
+		p->capacidade = 2 * p->capacidade + tamanho;
+	}
+	p->topo = p->topo + tamanho;
+	if (p->topo > p->maximo) p->maximo = p->topo;
+	return p->memoria + p->topo - tamanho;
+}
+
+void *topo_quadro(PilhaQuadros *p, size_t tamanho) {
+	return p->memoria + p->topo - ALINHA(tamanho);
+}
+
+void desempilha_quadro(PilhaQuadros *p, size_t tamanho) {
+	p->topo = p->topo - ALINHA(tamanho);
+}
+
+int pilha_vazia(PilhaQuadros *p) {
+	return p->topo == 0;
+}
+
+#define EMPILHA(p, Tipo) ((Tipo *) empilha_quadro((p), sizeof(Tipo)))
+#define TOPO(p, Tipo) ((Tipo *) topo_quadro((p), sizeof(Tipo)))
+#define DESEMPILHA(p, Tipo) desempilha_quadro((p), sizeof(Tipo))
+
+/* Árvores binárias de busca, como na aula sobre árvores */
+typedef struct noarvore {
+	int dado;
+	struct noarvore *f_esquerdo;
+	struct noarvore *f_direito;
+} NoArvore;
+
+void insere_binario(NoArvore **arvore, int dado) {
+	while (*arvore != NULL) {
+		if (dado >= (*arvore)->dado) arvore = &((*arvore)->f_direito);
+		else arvore = &((*arvore)->f_esquerdo);
+	}
+	(*arvore) = (NoArvore *) malloc(sizeof(NoArvore));
+	(*arvore)->dado = dado;
+	(*arvore)->f_esquerdo = NULL;
+	(*arvore)->f_direito = NULL;
+}
+
+/* Percurso em inordem, chamando visita() para cada nó.
+
+	 void inordem_recursiva(NoArvore *no, FuncaoVisita visita, void *contexto) {
+	   if (no == NULL) return;
+	   inordem_recursiva(no->f_esquerdo, visita, contexto);  <- estado 1 depois
+	   visita(no->dado, contexto);
+	   inordem_recursiva(no->f_direito, visita, contexto);   <- estado 2 depois
+	 }
+*/
+typedef void (*FuncaoVisita)(int dado, void *contexto);
+
+void inordem_recursiva(NoArvore *no, FuncaoVisita visita, void *contexto) {
+	if (no == NULL) return;
+	inordem_recursiva(no->f_esquerdo, visita, contexto);
+	visita(no->dado, contexto);
+	inordem_recursiva(no->f_direito, visita, contexto);
+}
+
+typedef struct quadroinordem {
+	NoArvore *no;
+	int estado;
+} QuadroInordem;
+
+/* Retorna 1 em caso de sucesso e 0 caso falte memória */
+int inordem_pilha(PilhaQuadros *p, NoArvore *raiz, FuncaoVisita visita, void *contexto) {
+	QuadroInordem *q;
+
+	if (raiz == NULL) return 1;
+	q = EMPILHA(p, QuadroInordem);
+	if (q == NULL) return 0;
+	q->no = raiz;
+	q->estado = 0;
+	while (!pilha_vazia(p)) {
+		q = TOPO(p, QuadroInordem);
+		switch (q->estado) {
+		case 0:
+			q->estado = 1;
+			if (q->no->f_esquerdo != NULL) {
+				NoArvore *filho = q->no->f_esquerdo;
+				q = EMPILHA(p, QuadroInordem);
+				if (q == NULL) return 0;
+				q->no = filho;
+				q->estado = 0;
+				break;
+			}
+			/* Sem filho esquerdo: segue direto para o estado 1 */
+			/* fall through */
+		case 1:
+			visita(q->no->dado, contexto);
+			q->estado = 2;
+			if (q->no->f_direito != NULL) {
+				NoArvore *filho = q->no->f_direito;
+				q = EMPILHA(p, QuadroInordem);
+				if (q == NULL) return 0;
+				q->no = filho;
+				q->estado = 0;
+				break;
+			}
+			/* fall through */
+		default:
+			DESEMPILHA(p, QuadroInordem);
+		}
+	}
+	return 1;
+}
+
+/* Altura da árvore: um exemplo em que a chamada usa os valores retornados
+	 pelas chamadas filhas. O valor retornado fica em p->retorno, e o quadro
+	 guarda a altura da subárvore esquerda enquanto a direita é calculada.
+
+	 int altura_recursiva(NoArvore *no) {
+	   int e, d;
+	   if (no == NULL) return 0;
+	   e = altura_recursiva(no->f_esquerdo);
+	   d = altura_recursiva(no->f_direito);
+	   return 1 + (e > d ? e : d);
+	 }
+*/
+int altura_recursiva(NoArvore *no) {
+	int e, d;
+	if (no == NULL) return 0;
+	e = altura_recursiva(no->f_esquerdo);
+	d = altura_recursiva(no->f_direito);
+	return 1 + (e > d ? e : d);
+}
+
+typedef struct quadroaltura {
+	NoArvore *no;
+	long altura_esquerda;
+	int estado;
+} QuadroAltura;
+
+long altura_pilha(PilhaQuadros *p, NoArvore *raiz) {
+	QuadroAltura *q;
+	NoArvore *filho;
+
+	p->retorno = 0;
+	if (raiz == NULL) return 0;
+	q = EMPILHA(p, QuadroAltura);
+	if (q == NULL) return -1;
+	q->no = raiz;
+	q->estado = 0;
+	while (!pilha_vazia(p)) {
+		q = TOPO(p, QuadroAltura);
+		if (q->estado == 0) { /* Chama para o filho esquerdo */
+			q->estado = 1;
+			filho = q->no->f_esquerdo;
+			p->retorno = 0;
+		} else if (q->estado == 1) { /* Chama para o filho direito */
+			q->altura_esquerda = p->retorno;
+			q->estado = 2;
+			filho = q->no->f_direito;
+			p->retorno = 0;
+		} else { /* Retorna */
+			if (q->altura_esquerda > p->retorno) p->retorno = q->altura_esquerda;
+			p->retorno = p->retorno + 1;
+			DESEMPILHA(p, QuadroAltura);
+			continue;
+		}
+		if (filho != NULL) { /* Chamadas com NULL retornam 0 imediatamente */
+			q = EMPILHA(p, QuadroAltura);
+			if (q == NULL) return -1;
+			q->no = filho;
+			q->estado = 0;
+		}
+	}
+	return p->retorno;
+}
+
+/* Quicksort, com pivô no primeiro elemento.
+
+	 void quick_sort_recursivo(int v[], int inicio, int fim) {
+	   int p;
+	   if (inicio >= fim) return;
+	   p = particiona(v, inicio, fim);
+	   quick_sort_recursivo(v, inicio, p - 1);   <- estado 1 depois
+	   quick_sort_recursivo(v, p + 1, fim);      <- estado 2 depois
+	 }
+*/
+void troca(int v[], int i, int j) {
+	int t = v[i];
+	v[i] = v[j];
+	v[j] = t;
+}
+
+int particiona(int v[], int inicio, int fim) {
+	int i, j;
+	j = inicio;
+	for (i = inicio + 1; i <= fim; i++)
+		if (v[i] < v[inicio]) {
+			j++;
+			troca(v, i, j);
+		}
+	troca(v, inicio, j);
+	return j;
+}
+
+void quick_sort_recursivo(int v[], int inicio, int fim) {
+	int p;
+	if (inicio >= fim) return;
+	p = particiona(v, inicio, fim);
+	quick_sort_recursivo(v, inicio, p - 1);
+	quick_sort_recursivo(v, p + 1, fim);
+}
+
+typedef struct quadroquick {
+	int inicio;
+	int fim;
+	int pivo;
+	int estado;
+} QuadroQuick;
+
+int quick_sort_pilha(PilhaQuadros *p, int v[], int n) {
+	QuadroQuick *q;
+	int inicio, fim;
+
+	q = EMPILHA(p, QuadroQuick);
+	if (q == NULL) return 0;
+	q->inicio = 0;
+	q->fim = n - 1;
+	q->estado = 0;
+	while (!pilha_vazia(p)) {
+		q = TOPO(p, QuadroQuick);
+		if ((q->estado == 0) && (q->inicio < q->fim)) {
+			q->pivo = particiona(v, q->inicio, q->fim);
+			q->estado = 1;
+			inicio = q->inicio;
+			fim = q->pivo - 1;
+		} else if (q->estado == 1) {
+			q->estado = 2;
+			inicio = q->pivo + 1;
+			fim = q->fim;
+		} else {
+			DESEMPILHA(p, QuadroQuick);
+			continue;
+		}
+		q = EMPILHA(p, QuadroQuick);
+		if (q == NULL) return 0;
+		q->inicio = inicio;
+		q->fim = fim;
+		q->estado = 0;
+	}
+	return 1;
+}
+
+/* Torres de Hanoi, como na aula de recursão. Cada movimento é passado para
+	 a função movimento(), que aqui apenas conta os movimentos.
+
+	 void hanoi_recursivo(int a, int b, int c, int n) {
+	   if (n == 1) { movimento(a, b); return; }
+	   hanoi_recursivo(a, c, b, n - 1);    <- estado 1 depois
+	   movimento(a, b);
+	   hanoi_recursivo(c, b, a, n - 1);    <- estado 2 depois
+	 }
+*/
+typedef void (*FuncaoMovimento)(int origem, int destino, void *contexto);
+
+void hanoi_recursivo(int a, int b, int c, int n, FuncaoMovimento movimento,
+										 void *contexto) {
+	if (n == 1) {
+		movimento(a, b, contexto);
+		return;
+	}
+	hanoi_recursivo(a, c, b, n - 1, movimento, contexto);
+	movimento(a, b, contexto);
+	hanoi_recursivo(c, b, a, n - 1, movimento, contexto);
+}
+
+typedef struct quadrohanoi {
+	char a, b, c;
+	char estado;
+	int n;
+} QuadroHanoi;
+
+int hanoi_pilha(PilhaQuadros *p, int a, int b, int c, int n,
+								FuncaoMovimento movimento, void *contexto) {
+	QuadroHanoi *q;
+	char na, nb, nc;
+
+	q = EMPILHA(p, QuadroHanoi);
+	if (q == NULL) return 0;
+	q->a = a;
+	q->b = b;
+	q->c = c;
+	q->n = n;
+	q->estado = 0;
+	while (!pilha_vazia(p)) {
+		q = TOPO(p, QuadroHanoi);
+		if ((q->estado == 0) && (q->n == 1)) {
+			movimento(q->a, q->b, contexto);
+			DESEMPILHA(p, QuadroHanoi);
+			continue;
+		} else if (q->estado == 0) {
+			q->estado = 1;
+			na = q->a;
+			nb = q->c;
+			nc = q->b;
+		} else if (q->estado == 1) {
+			movimento(q->a, q->b, contexto);
+			q->estado = 2;
+			na = q->c;
+			nb = q->b;
+			nc = q->a;
+		} else {
+			DESEMPILHA(p, QuadroHanoi);
+			continue;
+		}
+		n = q->n - 1;
+		if (n == 1) { /* Caso-base da chamada filha: não precisa de quadro */
+			movimento(na, nb, contexto);
+			continue;
+		}
+		q = EMPILHA(p, QuadroHanoi);
+		if (q == NULL) return 0;
+		q->a = na;
+		q->b = nb;
+		q->c = nc;
+		q->n = n;
+		q->estado = 0;
+	}
+	return 1;
+}
+
+/* Funções usadas nos testes */
+void soma_visita(int dado, void *contexto) {
+	*((long long *) contexto) = *((long long *) contexto) * 31 + dado;
+}
+
+void conta_movimento(int origem, int destino, void *contexto) {
+	*((long long *) contexto) = *((long long *) contexto) + origem * 3 + destino;
+}
+
+void imprime_movimento(int origem, int destino, void *contexto) {
+	(void) contexto;
+	printf("%d -> %d\n", origem, destino);
+}
+
+void imprime_visita(int dado, void *contexto) {
+	(void) contexto;
+	printf("%d ", dado);
+}
+
+void desaloca_arvore(PilhaQuadros *p, NoArvore *raiz) {
+	/* Também sem recursão: empilha os filhos e libera o nó */
+	NoArvore **q;
+	if (raiz == NULL) return;
+	*EMPILHA(p, NoArvore *) = raiz;
+	while (!pilha_vazia(p)) {
+		raiz = *TOPO(p, NoArvore *);
+		DESEMPILHA(p, NoArvore *);
+		if (raiz->f_esquerdo != NULL) {
+			q = EMPILHA(p, NoArvore *);
+			*q = raiz->f_esquerdo;
+		}
+		if (raiz->f_direito != NULL) {
+			q = EMPILHA(p, NoArvore *);
+			*q = raiz->f_direito;
+		}
+		free(raiz);
+	}
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+#define N_ARVORE 2000000
+#define N_VETOR 10000000
+#define N_HANOI 25
+#define PROFUNDIDADE 5000000
+
+int main() {
+	int valores[] = {50, 30, 70, 20, 40, 60, 80, 35};
+	PilhaQuadros p;
+	NoArvore *arvore, *cadeia, **final;
+	int *v1, *v2;
+	long long verificacao1, verificacao2;
+	struct timespec t1, t2;
+	struct rlimit limite;
+	int i;
+
+	inicia_pilha_quadros(&p);
+	arvore = NULL;
+	for (i = 0; i < 8; i++) insere_binario(&arvore, valores[i]);
+	printf("Inordem: ");
+	inordem_pilha(&p, arvore, imprime_visita, NULL);
+	printf("\nAltura: %ld\n", altura_pilha(&p, arvore));
+	desaloca_arvore(&p, arvore);
+	printf("Hanoi com 3 discos:\n");
+	hanoi_pilha(&p, 1, 2, 3, 3, imprime_movimento, NULL);
+
+	printf("---\nVelocidade (recursao nativa x pilha de quadros):\n");
+	srand(1);
+	arvore = NULL;
+	for (i = 0; i < N_ARVORE; i++) insere_binario(&arvore, rand());
+
+	verificacao1 = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	inordem_recursiva(arvore, soma_visita, &verificacao1);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Inordem, %d nos: nativa %f s", N_ARVORE, segundos(&t1, &t2));
+	verificacao2 = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	inordem_pilha(&p, arvore, soma_visita, &verificacao2);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf(", pilha %f s (%s)\n", segundos(&t1, &t2),
+				 verificacao1 == verificacao2 ? "iguais" : "diferentes");
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	verificacao1 = altura_recursiva(arvore);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Altura = %lld: nativa %f s", verificacao1, segundos(&t1, &t2));
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	verificacao2 = altura_pilha(&p, arvore);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf(", pilha %f s (%s)\n", segundos(&t1, &t2),
+				 verificacao1 == verificacao2 ? "iguais" : "diferentes");
+	desaloca_arvore(&p, arvore);
+
+	v1 = (int *) malloc(N_VETOR * sizeof(int));
+	v2 = (int *) malloc(N_VETOR * sizeof(int));
+	for (i = 0; i < N_VETOR; i++) v1[i] = v2[i] = rand();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	quick_sort_recursivo(v1, 0, N_VETOR - 1);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Quicksort, %d elementos: nativa %f s", N_VETOR, segundos(&t1, &t2));
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	quick_sort_pilha(&p, v2, N_VETOR);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	for (i = 0; (i < N_VETOR) && (v1[i] == v2[i]); i++);
+	printf(", pilha %f s (%s)\n", segundos(&t1, &t2),
+				 i == N_VETOR ? "iguais" : "diferentes");
+	free(v1);
+	free(v2);
+
+	verificacao1 = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	hanoi_recursivo(1, 2, 3, N_HANOI, conta_movimento, &verificacao1);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Hanoi, %d discos: nativa %f s", N_HANOI, segundos(&t1, &t2));
+	verificacao2 = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	hanoi_pilha(&p, 1, 2, 3, N_HANOI, conta_movimento, &verificacao2);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf(", pilha %f s (%s)\n", segundos(&t1, &t2),
+				 verificacao1 == verificacao2 ? "iguais" : "diferentes");
+
+	/* Profundidade: uma árvore em que cada nó só tem filho direito (o que
+		 acontece quando inserimos dados já ordenados) tem altura igual ao
+		 número de nós. Com a recursão nativa, cada nível ocupa dezenas de
+		 bytes da pilha de execução, e a chamada estouraria a pilha muito
+		 antes do fim; por isso, ela não é executada aqui. */
+	printf("---\nProfundidade:\n");
+	getrlimit(RLIMIT_STACK, &limite);
+	if (limite.rlim_cur == RLIM_INFINITY)
+		printf("Pilha de execucao: sem limite\n");
+	else
+		printf("Pilha de execucao: %lu bytes\n", (unsigned long) limite.rlim_cur);
+	cadeia = NULL;
+	final = &cadeia;
+	for (i = 0; i < PROFUNDIDADE; i++) {
+		*final = (NoArvore *) malloc(sizeof(NoArvore));
+		(*final)->dado = i;
+		(*final)->f_esquerdo = NULL;
+		(*final)->f_direito = NULL;
+		final = &((*final)->f_direito);
+	}
+	p.maximo = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	verificacao1 = altura_pilha(&p, cadeia);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Altura de uma cadeia de %d nos: %lld, em %f s, usando %lu bytes de quadros\n",
+				 PROFUNDIDADE, verificacao1, segundos(&t1, &t2), (unsigned long) p.maximo);
+	desaloca_arvore(&p, cadeia);
+
+	desaloca_pilha_quadros(&p);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -oeliminacao_recursao 17-eliminacao_recursao.c
+	 ./eliminacao_recursao
+*/
+
+/* Exercícios
+
+	 1) Escreva o percurso em pós-ordem da aula sobre árvores usando a pilha
+	 de quadros.
+
+	 2) No quicksort, o segundo quadro empilhado é o último trabalho do
+	 quadro de baixo. Modifique quick_sort_pilha() para reaproveitar o quadro
+	 atual nesse caso (eliminação de recursão de cauda) e empilhar sempre a
+	 metade menor. Qual passa a ser a profundidade máxima da pilha?
+
+	 3) Por que empilha_quadro() não pode simplesmente chamar malloc() para
+	 cada quadro, como as funções da aula sobre pilhas e filas fazem para
+	 cada nó?
+*/
@@ -0,0 +1,486 @@
+/* Simulação orientada a eventos: caixas de supermercado
+
+	 O exercício 3 da aula sobre pilhas e filas pede para simular N caixas
+	 de supermercado, com uma fila por caixa ou uma fila única, em que a
+	 cada instante chega um cliente com probabilidade P, e cada atendimento
+	 dura T instantes. A forma mais direta de programar isso é avançar o
+	 relógio de um em um instante e, em cada instante, sortear se chegou um
+	 cliente e verificar cada caixa. O problema é que quase todos os
+	 instantes são vazios: se T = 1000, um caixa passa 999 instantes só
+	 atendendo, e a simulação gasta tempo verificando cada um deles.
+
+	 Na simulação orientada a eventos, o relógio pula de um evento para o
+	 próximo. Há dois tipos de eventos: a chegada de um cliente e o fim de um
+	 atendimento. Os eventos futuros ficam numa fila de prioridades (o heap
+	 da aula 5), ordenada pelo instante em que acontecem; a cada passo,
+	 retiramos o evento mais próximo, avançamos o relógio até ele e o
+	 processamos, o que pode criar novos eventos. Em vez de sortear a cada
+	 instante se chega um cliente, sorteamos diretamente quantos instantes
+	 faltam para a próxima chegada. O número de sorteios até o primeiro
+	 sucesso, com probabilidade P em cada um, segue a distribuição
+	 geométrica, que pode ser sorteada com um único número aleatório U:
+
+	   instantes até a próxima chegada = 1 + piso(log(U) / log(1 - P))
+
+	 O custo passa a ser proporcional ao número de clientes (com um fator
+	 log do número de eventos pendentes), e não ao número de instantes.
+
+	 Para comparar configurações (número de caixas, carga, uma fila ou várias),
+	 fazemos uma varredura de parâmetros, e cada configuração é simulada
+	 independentemente, em paralelo. Para que os resultados não dependam do
+	 número de threads nem da ordem em que as configurações são executadas,
+	 cada configuração tem seu próprio gerador de números aleatórios, com uma
+	 semente calculada a partir do número da configuração.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Gerador de números aleatórios (SplitMix64). rand() tem um único estado
+	 compartilhado pelo programa inteiro e não serve para threads. */
+typedef struct gerador {
+	unsigned long long estado;
+} Gerador;
+
+unsigned long long proximo_aleatorio(Gerador *g) {
+	unsigned long long z;
+	g->estado = g->estado + 0x9E3779B97F4A7C15ULL;
+	z = g->estado;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* Sementes de configurações vizinhas não podem ser simplesmente base + n:
+	 como o estado avança somando uma constante, as sequências seriam a mesma
+	 sequência deslocada. Passamos base + n pelo próprio gerador, o que leva
+	 cada configuração a um ponto distante do ciclo. */
+unsigned long long semente_da_configuracao(unsigned long long base, int n) {
+	Gerador g;
+	g.estado = base + (unsigned long long) n;
+	return proximo_aleatorio(&g);
+}
+
+/* Número real uniforme em (0, 1] */
+double uniforme(Gerador *g) {
+	return ((proximo_aleatorio(g) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+long long geometrica(Gerador *g, double P) {
+	if (P >= 1) return 0;
+	return (long long) floor(log(uniforme(g)) / log(1 - P));
+}
+
+/* Fila de clientes: buffer circular de capacidade potência de 2, que
+	 cresce quando fica cheio (como a FilaVetor da aula sobre pilhas e
+	 filas). Cada cliente é representado pelo instante em que chegou. */
+typedef struct filaclientes {
+	int n_elementos;
+	unsigned int mascara;
+	unsigned int inicio;
+	long long *chegada;
+} FilaClientes;
+
+void inicia_fila(FilaClientes *f) {
+	f->n_elementos = 0;
+	f->mascara = 15;
+	f->inicio = 0;
+	f->chegada = (long long *) malloc(16 * sizeof(long long));
+}
+
+void insere_cliente(FilaClientes *f, long long chegada) {
+	unsigned int capacidade, i;
+	long long *nova;
+	if (f->n_elementos == (int) (f->mascara + 1)) {
+		capacidade = f->mascara + 1;
+		nova = (long long *) malloc(2 * capacidade * sizeof(long long));
+		for (i = 0; i < capacidade; i++)
+			nova[i] = f->chegada[(f->inicio + i) & f->mascara];
+		free(f->chegada);
+		f->chegada = nova;
+		f->mascara = 2 * capacidade - 1;
+		f->inicio = 0;
+	}
+	f->chegada[(f->inicio + f->n_elementos) & f->mascara] = chegada;
+	f->n_elementos = f->n_elementos + 1;
+}
+
+long long remove_cliente(FilaClientes *f) {
+	long long chegada = f->chegada[f->inicio & f->mascara];
+	f->inicio = f->inicio + 1;
+	f->n_elementos = f->n_elementos - 1;
+	return chegada;
+}
+
+/* Fila de prioridades de eventos: heap em vetor, como na aula 5, mas com o
+	 menor instante na raiz. Quando dois eventos acontecem no mesmo instante,
+	 os fins de atendimento vêm antes das chegadas, para que um caixa que
+	 acabou de ficar livre possa atender quem chega naquele instante. */
+#define FIM_ATENDIMENTO 0
+#define CHEGADA 1
+
+typedef struct evento {
+	long long instante;
+	int tipo;
+	int caixa;
+} Evento;
+
+typedef struct heapeventos {
+	int n_elementos;
+	int capacidade;
+	Evento *eventos;
+} HeapEventos;
+
+int pai(int N) {
+	return ((N-1)/2);
+}
+
+int f_esquerdo(int N) {
+	return (2*N)+1;
+}
+
+int f_direito(int N) {
+	return (2*N)+2;
+}
+
+int antes(Evento *a, Evento *b) {
+	if (a->instante != b->instante) return a->instante < b->instante;
+	return a->tipo < b->tipo;
+}
+
+void insere_evento(HeapEventos *h, long long instante, int tipo, int caixa) {
+	Evento novo;
+	int N;
+
+	if (h->n_elementos == h->capacidade) {
+		h->capacidade = 2 * h->capacidade;
+		h->eventos = (Evento *) realloc(h->eventos, h->capacidade * sizeof(Evento));
+	}
+	novo.instante = instante;
+	novo.tipo = tipo;
+	novo.caixa = caixa;
+
+	/* Sobe a partir da última posição, deslocando os pais para baixo */
+	N = h->n_elementos;
+	h->n_elementos = h->n_elementos + 1;
+	while ((N > 0) && antes(&novo, &(h->eventos[pai(N)]))) {
+		h->eventos[N] = h->eventos[pai(N)];
+		N = pai(N);
+	}
+	h->eventos[N] = novo;
+}
+
+Evento retira_evento(HeapEventos *h) {
+	Evento primeiro, ultimo;
+	int N, descida;
+
+	primeiro = h->eventos[0];
+	h->n_elementos = h->n_elementos - 1;
+	ultimo = h->eventos[h->n_elementos];
+
+	/* O último evento desce a partir da raiz */
+	N = 0;
+	while (f_esquerdo(N) < h->n_elementos) {
+		descida = f_esquerdo(N);
+		if ((f_direito(N) < h->n_elementos) &&
+				antes(&(h->eventos[f_direito(N)]), &(h->eventos[descida])))
+			descida = f_direito(N);
+		if (!antes(&(h->eventos[descida]), &ultimo)) break;
+		h->eventos[N] = h->eventos[descida];
+		N = descida;
+	}
+	h->eventos[N] = ultimo;
+	return primeiro;
+}
+
+/* Configuração e resultado de uma simulação */
+typedef struct configuracao {
+	int n_caixas;
+	int fila_unica; /* 1: uma fila para todos; 0: uma fila por caixa */
+	double P; /* Probabilidade de chegada em cada instante */
+	long long T; /* Duração de um atendimento */
+	int n_clientes;
+	unsigned long long semente;
+} Configuracao;
+
+typedef struct resultado {
+	double espera_media;
+	long long ocioso_total; /* Soma do tempo ocioso de todos os caixas */
+	long long duracao; /* Instante em que o último atendimento termina */
+} Resultado;
+
+#define MAX_CAIXAS 64
+
+/* Começa o atendimento de um cliente que chegou em "chegada" no caixa c */
+void atende(HeapEventos *h, long long agora, long long chegada, int c, long long T,
+						int ocupado[], long long livre_desde[], long long *ocioso,
+						long long *espera) {
+	*ocioso = *ocioso + (agora - livre_desde[c]);
+	*espera = *espera + (agora - chegada);
+	ocupado[c] = 1;
+	insere_evento(h, agora + T, FIM_ATENDIMENTO, c);
+}
+
+Resultado simula_eventos(Configuracao *cfg) {
+	HeapEventos h;
+	FilaClientes filas[MAX_CAIXAS];
+	int ocupado[MAX_CAIXAS];
+	long long livre_desde[MAX_CAIXAS];
+	Gerador g;
+	Evento e;
+	Resultado r;
+	long long ocioso, espera, agora;
+	int chegaram, c, f, n_filas;
+
+	g.estado = cfg->semente;
+	n_filas = cfg->fila_unica ? 1 : cfg->n_caixas;
+	for (f = 0; f < n_filas; f++) inicia_fila(&filas[f]);
+	for (c = 0; c < cfg->n_caixas; c++) {
+		ocupado[c] = 0;
+		livre_desde[c] = 0;
+	}
+	h.n_elementos = 0;
+	h.capacidade = 2 * MAX_CAIXAS;
+	h.eventos = (Evento *) malloc(h.capacidade * sizeof(Evento));
+
+	ocioso = 0;
+	espera = 0;
+	agora = 0;
+	chegaram = 1;
+	insere_evento(&h, geometrica(&g, cfg->P), CHEGADA, 0);
+
+	while (h.n_elementos > 0) {
+		e = retira_evento(&h);
+		agora = e.instante;
+		if (e.tipo == CHEGADA) {
+			if (chegaram < cfg->n_clientes) { /* Agenda a próxima chegada */
+				insere_evento(&h, agora + 1 + geometrica(&g, cfg->P), CHEGADA, 0);
+				chegaram++;
+			}
+			if (cfg->fila_unica) {
+				f = 0;
+				for (c = 0; (c < cfg->n_caixas) && ocupado[c]; c++);
+			} else {
+				f = (int) (proximo_aleatorio(&g) % cfg->n_caixas);
+				c = f;
+				if (ocupado[c] || (filas[f].n_elementos > 0)) c = cfg->n_caixas;
+			}
+			if (c < cfg->n_caixas) /* Há um caixa livre */
+				atende(&h, agora, agora, c, cfg->T, ocupado, livre_desde, &ocioso, &espera);
+			else
+				insere_cliente(&filas[f], agora);
+		} else {
+			c = e.caixa;
+			ocupado[c] = 0;
+			livre_desde[c] = agora;
+			f = cfg->fila_unica ? 0 : c;
+			if (filas[f].n_elementos > 0)
+				atende(&h, agora, remove_cliente(&filas[f]), c, cfg->T, ocupado,
+							 livre_desde, &ocioso, &espera);
+		}
+	}
+
+	/* Os caixas ficam ociosos do fim do último atendimento até o fim */
+	for (c = 0; c < cfg->n_caixas; c++)
+		ocioso = ocioso + (agora - livre_desde[c]);
+
+	r.espera_media = espera / (double) cfg->n_clientes;
+	r.ocioso_total = ocioso;
+	r.duracao = agora;
+	for (f = 0; f < n_filas; f++) free(filas[f].chegada);
+	free(h.eventos);
+	return r;
+}
+
+/* Simulação instante a instante, como sugerida no exercício, usada para
+	 comparação. Os sorteios são feitos de outra forma (um por instante), de
+	 forma que os resultados não são idênticos aos da simulação por eventos,
+	 mas devem ser estatisticamente equivalentes. */
+Resultado simula_instantes(Configuracao *cfg) {
+	FilaClientes filas[MAX_CAIXAS];
+	long long fim[MAX_CAIXAS];
+	int ocupado[MAX_CAIXAS];
+	Gerador g;
+	Resultado r;
+	long long ocioso, espera, agora;
+	int chegaram, atendidos, c, f, n_filas;
+
+	g.estado = cfg->semente;
+	n_filas = cfg->fila_unica ? 1 : cfg->n_caixas;
+	for (f = 0; f < n_filas; f++) inicia_fila(&filas[f]);
+	for (c = 0; c < cfg->n_caixas; c++) ocupado[c] = 0;
+
+	ocioso = 0;
+	espera = 0;
+	chegaram = 0;
+	atendidos = 0;
+	for (agora = 0; atendidos < cfg->n_clientes; agora++) {
+		for (c = 0; c < cfg->n_caixas; c++)
+			if (ocupado[c] && (fim[c] == agora)) {
+				ocupado[c] = 0;
+				atendidos++;
+			}
+		if ((chegaram < cfg->n_clientes) && (uniforme(&g) <= cfg->P)) {
+			f = cfg->fila_unica ? 0 : (int) (proximo_aleatorio(&g) % cfg->n_caixas);
+			insere_cliente(&filas[f], agora);
+			chegaram++;
+		}
+		for (c = 0; c < cfg->n_caixas; c++) {
+			f = cfg->fila_unica ? 0 : c;
+			if (!ocupado[c] && (filas[f].n_elementos > 0)) {
+				espera = espera + (agora - remove_cliente(&filas[f]));
+				ocupado[c] = 1;
+				fim[c] = agora + cfg->T;
+			}
+			if (!ocupado[c]) ocioso++;
+		}
+	}
+
+	r.espera_media = espera / (double) cfg->n_clientes;
+	r.ocioso_total = ocioso - cfg->n_caixas; /* O último instante já é depois do fim */
+	r.duracao = agora - 1;
+	for (f = 0; f < n_filas; f++) free(filas[f].chegada);
+	return r;
+}
+
+/* Varredura de parâmetros em paralelo. A thread t simula as configurações
+	 t, t + n_threads, t + 2 n_threads, ... e guarda cada resultado na
+	 posição da configuração, de forma que a saída não depende da ordem em
+	 que as threads terminam. */
+#define MAX_THREADS 64
+
+typedef struct tarefa {
+	Configuracao *configuracoes;
+	Resultado *resultados;
+	int n_configuracoes;
+	int thread;
+	int n_threads;
+} Tarefa;
+
+void *executa_tarefa(void *p) {
+	Tarefa *t = (Tarefa *) p;
+	int i;
+	for (i = t->thread; i < t->n_configuracoes; i = i + t->n_threads)
+		t->resultados[i] = simula_eventos(&(t->configuracoes[i]));
+	return NULL;
+}
+
+void varredura(Configuracao cfg[], Resultado res[], int n, int n_threads) {
+	pthread_t threads[MAX_THREADS];
+	Tarefa tarefas[MAX_THREADS];
+	int t;
+	if (n_threads < 1) n_threads = 1;
+	for (t = 0; t < n_threads; t++) {
+		tarefas[t].configuracoes = cfg;
+		tarefas[t].resultados = res;
+		tarefas[t].n_configuracoes = n;
+		tarefas[t].thread = t;
+		tarefas[t].n_threads = n_threads;
+		if (t > 0) pthread_create(&threads[t], NULL, executa_tarefa, &tarefas[t]);
+	}
+	executa_tarefa(&tarefas[0]);
+	for (t = 1; t < n_threads; t++)
+		pthread_join(threads[t], NULL);
+}
+
+int numero_de_threads() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1) return 1;
+	if (n > MAX_THREADS) return MAX_THREADS;
+	return (int) n;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+#define SEMENTE 2024
+#define N_CLIENTES 1000000
+#define N_CLIENTES_COMPARACAO 200000
+#define TEMPO_ATENDIMENTO 100
+
+int main() {
+	int caixas[] = {1, 2, 4, 8};
+	double cargas[] = {0.5, 0.8, 0.9, 0.95};
+	Configuracao cfg[32], comparacao;
+	Resultado res[32], r1, r2;
+	struct timespec t1, t2;
+	int i, j, k, n, n_threads;
+
+	/* Comparação entre as duas formas de simular. A carga de um caixa é a
+		 fração do tempo em que ele fica ocupado: P * T / N. */
+	comparacao.n_caixas = 4;
+	comparacao.fila_unica = 0;
+	comparacao.T = 1000;
+	comparacao.P = 0.9 * comparacao.n_caixas / comparacao.T;
+	comparacao.n_clientes = N_CLIENTES_COMPARACAO;
+	comparacao.semente = SEMENTE;
+	printf("%d clientes, 4 caixas com uma fila cada, T = 1000, carga 0.9:\n",
+				 N_CLIENTES_COMPARACAO);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	r1 = simula_instantes(&comparacao);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Instante a instante: %f s, espera media %.1f, ocioso %.3f%%\n",
+				 segundos(&t1, &t2), r1.espera_media,
+				 100.0 * r1.ocioso_total / (4.0 * r1.duracao));
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	r2 = simula_eventos(&comparacao);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Por eventos:         %f s, espera media %.1f, ocioso %.3f%%\n",
+				 segundos(&t1, &t2), r2.espera_media,
+				 100.0 * r2.ocioso_total / (4.0 * r2.duracao));
+
+	/* Varredura: 2 tipos de fila x 4 números de caixas x 4 cargas */
+	n = 0;
+	for (k = 0; k < 2; k++)
+		for (i = 0; i < 4; i++)
+			for (j = 0; j < 4; j++) {
+				cfg[n].n_caixas = caixas[i];
+				cfg[n].fila_unica = k;
+				cfg[n].T = TEMPO_ATENDIMENTO;
+				cfg[n].P = cargas[j] * caixas[i] / TEMPO_ATENDIMENTO;
+				cfg[n].n_clientes = N_CLIENTES;
+				cfg[n].semente = semente_da_configuracao(SEMENTE, n);
+				n++;
+			}
+
+	n_threads = numero_de_threads();
+	printf("---\nVarredura: %d configuracoes, %d clientes cada, T = %d, %d threads\n",
+				 n, N_CLIENTES, TEMPO_ATENDIMENTO, n_threads);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	varredura(cfg, res, n, n_threads);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Tempo: %f s (%e clientes/s)\n", segundos(&t1, &t2),
+				 (double) n * N_CLIENTES / segundos(&t1, &t2));
+
+	printf("filas\tcaixas\tcarga\tespera media\tocioso por caixa\n");
+	for (i = 0; i < n; i++)
+		printf("%s\t%d\t%.2f\t%12.1f\t%.2f%%\n", cfg[i].fila_unica ? "unica" : "varias",
+					 cfg[i].n_caixas, cfg[i].P * cfg[i].T / cfg[i].n_caixas,
+					 res[i].espera_media,
+					 100.0 * res[i].ocioso_total / ((double) cfg[i].n_caixas * res[i].duracao));
+	return 0;
+}
+
+/* Para executar (-lm por causa de log(), -pthread por causa das threads):
+	 gcc -O2 -pthread -osimulacao_caixas 18-simulacao_caixas.c -lm
+	 ./simulacao_caixas
+*/
+
+/* Exercícios
+
+	 1) Com uma fila por caixa, o cliente escolhe a fila aleatoriamente.
+	 Modifique a simulação para que ele escolha a fila mais curta. Quanto a
+	 espera média diminui?
+
+	 2) Troque o tempo de atendimento constante por um tempo sorteado (por
+	 exemplo, T/2 + um número geométrico de média T/2). O que acontece com a
+	 espera média para a mesma carga?
+
+	 3) Por que a espera média cresce tão rapidamente quando a carga se
+	 aproxima de 1?
+*/
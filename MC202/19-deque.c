@@ -0,0 +1,467 @@
+/* Deque: fila com duas pontas
+
+	 A Lista da aula sobre pilhas e filas guarda ponteiros para o início e
+	 para o final, mas só consegue remover do início: para remover o último
+	 nó, precisaríamos do penúltimo, e encontrá-lo exige percorrer a lista
+	 inteira. Uma estrutura que permite inserir e remover nas duas pontas em
+	 O(1) é chamada de deque (double-ended queue). Com listas, isso exige
+	 nós duplamente ligados, como na aula sobre listas duplas.
+
+	 Aqui, construímos o deque com vetores, da forma usada pelo std::deque
+	 de C++. Os elementos ficam em blocos de tamanho fixo (ELEMENTOS_POR_BLOCO,
+	 uma potência de 2), e um vetor de ponteiros para blocos, o mapa, diz
+	 onde está cada bloco:
+
+	   mapa: [ . | * | * | * | . ]
+	               |   |   |
+	               |   |   +-> [ g h i . . . . . ]
+	               |   +-----> [ c d e f . . . . ]  (blocos cheios no meio)
+	               +---------> [ . . . . . a b ]
+
+	 O deque guarda a posição do primeiro elemento, contada a partir do
+	 começo do primeiro bloco do mapa, e o número de elementos. O elemento
+	 de índice i está na posição p = inicio + i, ou seja, no bloco
+	 p / ELEMENTOS_POR_BLOCO, na posição p % ELEMENTOS_POR_BLOCO dele. Como o
+	 tamanho do bloco é potência de 2, essas contas são um deslocamento e um
+	 E bit a bit, e o acesso por índice é O(1), como num vetor.
+
+	 Inserir numa ponta é escrever na posição vizinha; quando o bloco da
+	 ponta acaba, alocamos um bloco novo. Quando o mapa acaba, alocamos um
+	 mapa maior e copiamos os ponteiros para o meio dele (os elementos não
+	 são copiados). Ao contrário de um vetor que cresce com realloc(), os
+	 elementos nunca mudam de lugar. Os elementos vizinhos estão na mesma
+	 região da memória, o que faz bom uso da cache, e cada bloco custa um
+	 único malloc() para ELEMENTOS_POR_BLOCO elementos.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_BLOCO 9
+#define ELEMENTOS_POR_BLOCO (1 << LOG_BLOCO)
+#define MASCARA_BLOCO (ELEMENTOS_POR_BLOCO - 1)
+
+typedef struct deque {
+	int **mapa;
+	long tamanho_mapa; /* Número de posições do mapa */
+	long inicio; /* Posição do primeiro elemento */
+	long n_elementos;
+	int *reserva; /* Um bloco vazio guardado para reuso */
+} Deque;
+
+Deque *novo_deque() {
+	Deque *d;
+	d = (Deque *) malloc(sizeof(Deque));
+	d->tamanho_mapa = 8;
+	d->mapa = (int **) calloc(d->tamanho_mapa, sizeof(int *));
+	/* Começamos no meio do mapa, para que as duas pontas possam crescer */
+	d->inicio = (d->tamanho_mapa / 2) * ELEMENTOS_POR_BLOCO;
+	d->n_elementos = 0;
+	d->reserva = NULL;
+	return d;
+}
+
+void desaloca_deque(Deque *d) {
+	long b;
+	for (b = 0; b < d->tamanho_mapa; b++)
+		free(d->mapa[b]);
+	free(d->reserva);
+	free(d->mapa);
+	free(d);
+}
+
+/* Um bloco que ficou vazio vira a reserva, em vez de ser liberado
+	 imediatamente. Sem isso, inserir e remover alternadamente na fronteira
+	 de um bloco chamaria malloc() e free() a cada operação. */
+int *aloca_bloco(Deque *d) {
+	int *bloco;
+	if (d->reserva != NULL) {
+		bloco = d->reserva;
+		d->reserva = NULL;
+		return bloco;
+	}
+	return (int *) malloc(ELEMENTOS_POR_BLOCO * sizeof(int));
+}
+
+void libera_bloco(Deque *d, long b) {
+	if (d->reserva == NULL) d->reserva = d->mapa[b];
+	else free(d->mapa[b]);
+	d->mapa[b] = NULL;
+}
+
+/* Cria um mapa com o dobro do tamanho necessário e centraliza os blocos
+	 em uso nele. Retorna 0 caso não haja memória. */
+int recentraliza_mapa(Deque *d) {
+	long primeiro, ultimo, usados, novo_tamanho, deslocamento;
+	int **novo;
+
+	primeiro = d->inicio >> LOG_BLOCO;
+	ultimo = (d->inicio + d->n_elementos - 1) >> LOG_BLOCO;
+	if (d->n_elementos == 0) ultimo = primeiro;
+	usados = ultimo - primeiro + 1;
+	novo_tamanho = 2 * (usados + 2);
+	if (novo_tamanho < d->tamanho_mapa) novo_tamanho = d->tamanho_mapa;
+
+	novo = (int **) calloc(novo_tamanho, sizeof(int *));
+	if (novo == NULL) return 0;
+	deslocamento = (novo_tamanho - usados) / 2;
+	memcpy(&novo[deslocamento], &(d->mapa[primeiro]), usados * sizeof(int *));
+	free(d->mapa);
+	d->mapa = novo;
+	d->tamanho_mapa = novo_tamanho;
+	d->inicio = d->inicio + (deslocamento - primeiro) * ELEMENTOS_POR_BLOCO;
+	return 1;
+}
+
+/* As funções de inserção retornam 1 em caso de sucesso e 0 caso não haja
+	 memória disponível */
+int deque_insere_final(Deque *d, int dado) {
+	long p = d->inicio + d->n_elementos;
+	if ((p >> LOG_BLOCO) >= d->tamanho_mapa) {
+		if (!recentraliza_mapa(d)) return 0;
+		p = d->inicio + d->n_elementos;
+	}
+	if (d->mapa[p >> LOG_BLOCO] == NULL) {
+		d->mapa[p >> LOG_BLOCO] = aloca_bloco(d);
+		if (d->mapa[p >> LOG_BLOCO] == NULL) return 0;
+	}
+	d->mapa[p >> LOG_BLOCO][p & MASCARA_BLOCO] = dado;
+	d->n_elementos = d->n_elementos + 1;
+	return 1;
+}
+
+int deque_insere_comeco(Deque *d, int dado) {
+	long p;
+	if (d->inicio == 0)
+		if (!recentraliza_mapa(d)) return 0;
+	p = d->inicio - 1;
+	if (d->mapa[p >> LOG_BLOCO] == NULL) {
+		d->mapa[p >> LOG_BLOCO] = aloca_bloco(d);
+		if (d->mapa[p >> LOG_BLOCO] == NULL) return 0;
+	}
+	d->mapa[p >> LOG_BLOCO][p & MASCARA_BLOCO] = dado;
+	d->inicio = p;
+	d->n_elementos = d->n_elementos + 1;
+	return 1;
+}
+
+/* As funções de remoção retornam 1 e escrevem o dado em *dado, ou retornam
+	 0 se o deque está vazio */
+int deque_retira_comeco(Deque *d, int *dado) {
+	long p = d->inicio;
+	if (d->n_elementos == 0) return 0;
+	*dado = d->mapa[p >> LOG_BLOCO][p & MASCARA_BLOCO];
+	d->inicio = p + 1;
+	d->n_elementos = d->n_elementos - 1;
+	/* Saímos do bloco, ou o deque ficou vazio: o bloco não é mais usado */
+	if (((d->inicio & MASCARA_BLOCO) == 0) || (d->n_elementos == 0))
+		libera_bloco(d, p >> LOG_BLOCO);
+	return 1;
+}
+
+int deque_retira_final(Deque *d, int *dado) {
+	long p = d->inicio + d->n_elementos - 1;
+	if (d->n_elementos == 0) return 0;
+	*dado = d->mapa[p >> LOG_BLOCO][p & MASCARA_BLOCO];
+	d->n_elementos = d->n_elementos - 1;
+	if (((p & MASCARA_BLOCO) == 0) || (d->n_elementos == 0))
+		libera_bloco(d, p >> LOG_BLOCO);
+	return 1;
+}
+
+/* Acesso ao elemento de índice i (0 é o primeiro), em O(1) */
+int *deque_elemento(Deque *d, long i) {
+	long p = d->inicio + i;
+	return &(d->mapa[p >> LOG_BLOCO][p & MASCARA_BLOCO]);
+}
+
+void imprime_deque(Deque *d) {
+	long i;
+	for (i = 0; i < d->n_elementos; i++)
+		printf("%d ", *deque_elemento(d, i));
+	printf("\n");
+}
+
+/* Versão ligada, para comparação: nós duplamente ligados, com os nós
+	 removidos guardados numa lista de livres para reuso (como o pool das
+	 aulas anteriores), de forma que a comparação mede a estrutura, e não
+	 o malloc(). */
+typedef struct nodupla {
+	int dado;
+	struct nodupla *anterior;
+	struct nodupla *proximo;
+} NoDupla;
+
+typedef struct dequeligado {
+	NoDupla *inicio;
+	NoDupla *final;
+	long n_elementos;
+	NoDupla *livres;
+} DequeLigado;
+
+DequeLigado *novo_deque_ligado() {
+	DequeLigado *d;
+	d = (DequeLigado *) malloc(sizeof(DequeLigado));
+	d->inicio = NULL;
+	d->final = NULL;
+	d->n_elementos = 0;
+	d->livres = NULL;
+	return d;
+}
+
+NoDupla *novo_no(DequeLigado *d, int dado) {
+	NoDupla *no;
+	if (d->livres != NULL) {
+		no = d->livres;
+		d->livres = no->proximo;
+	} else {
+		no = (NoDupla *) malloc(sizeof(NoDupla));
+	}
+	no->dado = dado;
+	return no;
+}
+
+void ligado_insere_final(DequeLigado *d, int dado) {
+	NoDupla *no = novo_no(d, dado);
+	no->proximo = NULL;
+	no->anterior = d->final;
+	if (d->final != NULL) d->final->proximo = no;
+	else d->inicio = no;
+	d->final = no;
+	d->n_elementos = d->n_elementos + 1;
+}
+
+int ligado_retira_comeco(DequeLigado *d, int *dado) {
+	NoDupla *no = d->inicio;
+	if (no == NULL) return 0;
+	*dado = no->dado;
+	d->inicio = no->proximo;
+	if (d->inicio != NULL) d->inicio->anterior = NULL;
+	else d->final = NULL;
+	no->proximo = d->livres;
+	d->livres = no;
+	d->n_elementos = d->n_elementos - 1;
+	return 1;
+}
+
+int ligado_retira_final(DequeLigado *d, int *dado) {
+	NoDupla *no = d->final;
+	if (no == NULL) return 0;
+	*dado = no->dado;
+	d->final = no->anterior;
+	if (d->final != NULL) d->final->proximo = NULL;
+	else d->inicio = NULL;
+	no->proximo = d->livres;
+	d->livres = no;
+	d->n_elementos = d->n_elementos - 1;
+	return 1;
+}
+
+void desaloca_deque_ligado(DequeLigado *d) {
+	NoDupla *no;
+	int dado;
+	while (ligado_retira_comeco(d, &dado));
+	while (d->livres != NULL) {
+		no = d->livres;
+		d->livres = no->proximo;
+		free(no);
+	}
+	free(d);
+}
+
+/* Teste de desempenho: roubo de tarefas (work stealing)
+
+	 Em escalonadores de tarefas paralelos, cada trabalhador tem seu próprio
+	 deque. O trabalhador insere e retira tarefas do final do seu deque (como
+	 uma pilha, o que mantém na cache os dados da tarefa mais recente) e,
+	 quando seu deque fica vazio, rouba uma tarefa do começo do deque de
+	 outro trabalhador (a mais antiga, que tende a gerar mais trabalho).
+
+	 Simulamos isso com N_TRABALHADORES deques, numa única thread, com os
+	 trabalhadores se revezando. Cada tarefa é um número d; processá-la gera
+	 duas tarefas d-1 (se d > 0), de forma que uma tarefa inicial PROFUNDIDADE
+	 gera 2^(PROFUNDIDADE+1) - 1 tarefas no total. Nesse padrão, cada deque
+	 tem poucas dezenas de tarefas, e tudo cabe na cache.
+
+	 No segundo padrão (um laço paralelo), o primeiro trabalhador recebe
+	 N_ITENS tarefas de uma vez, e os outros as roubam do começo enquanto ele
+	 consome do final. Agora o deque tem milhões de elementos, e a memória
+	 ocupada por elemento faz diferença. A sequência de operações é a mesma
+	 para as duas implementações. */
+#define N_TRABALHADORES 8
+#define PROFUNDIDADE 22
+#define N_ITENS (1 << 23)
+
+typedef struct operacoes {
+	void *(*novo)();
+	void (*insere_final)(void *, int);
+	int (*retira_final)(void *, int *);
+	int (*retira_comeco)(void *, int *);
+	void (*desaloca)(void *);
+} Operacoes;
+
+/* Funções de adaptação com parâmetros void *, para usar nas Operacoes */
+void *novo_vetor() { return novo_deque(); }
+void insere_vetor(void *d, int dado) { deque_insere_final((Deque *) d, dado); }
+int retira_final_vetor(void *d, int *dado) { return deque_retira_final((Deque *) d, dado); }
+int retira_comeco_vetor(void *d, int *dado) { return deque_retira_comeco((Deque *) d, dado); }
+void desaloca_vetor(void *d) { desaloca_deque((Deque *) d); }
+
+void *novo_ligado() { return novo_deque_ligado(); }
+void insere_ligado(void *d, int dado) { ligado_insere_final((DequeLigado *) d, dado); }
+int retira_final_ligado(void *d, int *dado) { return ligado_retira_final((DequeLigado *) d, dado); }
+int retira_comeco_ligado(void *d, int *dado) { return ligado_retira_comeco((DequeLigado *) d, dado); }
+void desaloca_ligado(void *d) { desaloca_deque_ligado((DequeLigado *) d); }
+
+/* Retorna o número de tarefas processadas; *roubos recebe quantas foram
+	 roubadas */
+long roubo_de_tarefas(Operacoes *op, int n_iniciais, int profundidade, long *roubos) {
+	void *deques[N_TRABALHADORES];
+	int pendentes[N_TRABALHADORES]; /* Tarefas pendentes em cada deque */
+	long processadas, total_pendentes;
+	int w, vitima, tarefa, tentativa;
+
+	for (w = 0; w < N_TRABALHADORES; w++) {
+		deques[w] = op->novo();
+		pendentes[w] = 0;
+	}
+	for (tarefa = 0; tarefa < n_iniciais; tarefa++)
+		op->insere_final(deques[0], profundidade);
+	pendentes[0] = n_iniciais;
+	total_pendentes = n_iniciais;
+	processadas = 0;
+	*roubos = 0;
+
+	while (total_pendentes > 0) {
+		for (w = 0; w < N_TRABALHADORES; w++) {
+			if (op->retira_final(deques[w], &tarefa)) {
+				pendentes[w]--;
+			} else { /* Rouba do começo do deque da próxima vítima com tarefas */
+				for (tentativa = 1; tentativa < N_TRABALHADORES; tentativa++) {
+					vitima = (w + tentativa) % N_TRABALHADORES;
+					if (op->retira_comeco(deques[vitima], &tarefa)) {
+						pendentes[vitima]--;
+						(*roubos)++;
+						break;
+					}
+				}
+				if (tentativa == N_TRABALHADORES) continue; /* Nada para roubar */
+			}
+			processadas++;
+			total_pendentes--;
+			if (tarefa > 0) {
+				op->insere_final(deques[w], tarefa - 1);
+				op->insere_final(deques[w], tarefa - 1);
+				pendentes[w] = pendentes[w] + 2;
+				total_pendentes = total_pendentes + 2;
+			}
+		}
+	}
+
+	for (w = 0; w < N_TRABALHADORES; w++) op->desaloca(deques[w]);
+	return processadas;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+#define N_ACESSO 10000000
+
+int main() {
+	Operacoes vetor = {novo_vetor, insere_vetor, retira_final_vetor,
+										 retira_comeco_vetor, desaloca_vetor};
+	Operacoes ligado = {novo_ligado, insere_ligado, retira_final_ligado,
+											retira_comeco_ligado, desaloca_ligado};
+	Deque *d;
+	struct timespec t1, t2;
+	long processadas, roubos, i, erros;
+	long long soma;
+	int dado, esperado, padrao, n_iniciais, profundidade;
+
+	d = novo_deque();
+	for (i = 1; i <= 5; i++) {
+		deque_insere_final(d, i);
+		deque_insere_comeco(d, -i);
+	}
+	printf("Deque: ");
+	imprime_deque(d);
+	deque_retira_comeco(d, &dado);
+	printf("Retirado do comeco: %d\n", dado);
+	deque_retira_final(d, &dado);
+	printf("Retirado do final: %d\n", dado);
+	printf("Elemento de indice 3: %d\n", *deque_elemento(d, 3));
+	desaloca_deque(d);
+
+	/* Verificação: muitas operações alternadas nas duas pontas, atravessando
+		 fronteiras de blocos e forçando o mapa a crescer */
+	d = novo_deque();
+	erros = 0;
+	for (i = 0; i < N_ACESSO; i++) {
+		if (i % 3 == 0) deque_insere_comeco(d, (int) i);
+		else deque_insere_final(d, (int) i);
+	}
+	soma = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < d->n_elementos; i++)
+		soma = soma + *deque_elemento(d, i);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	if (soma != (long long) N_ACESSO * (N_ACESSO - 1) / 2) erros++;
+	printf("Acesso por indice a %d elementos: %f s\n", N_ACESSO, segundos(&t1, &t2));
+	/* Pelo final, saem primeiro os valores inseridos no final, do maior para
+		 o menor, e depois os inseridos no começo, do menor para o maior */
+	esperado = N_ACESSO - 1;
+	while ((esperado >= 0) && (esperado % 3 == 0)) esperado--;
+	for (i = 0; deque_retira_final(d, &dado); i++) {
+		if (dado != esperado) erros++;
+		if (dado % 3 != 0) {
+			do esperado--; while ((esperado >= 0) && (esperado % 3 == 0));
+			if (esperado < 0) esperado = 0;
+		} else {
+			esperado = dado + 3;
+		}
+	}
+	if (i != N_ACESSO) erros++;
+	printf("Erros: %ld\n", erros);
+	desaloca_deque(d);
+
+	printf("---\nRoubo de tarefas, %d trabalhadores:\n", N_TRABALHADORES);
+	for (padrao = 0; padrao < 2; padrao++) {
+		n_iniciais = (padrao == 0) ? 1 : N_ITENS;
+		profundidade = (padrao == 0) ? PROFUNDIDADE : 0;
+		printf("%s:\n", (padrao == 0) ? "Arvore de tarefas" : "Laco paralelo");
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		processadas = roubo_de_tarefas(&ligado, n_iniciais, profundidade, &roubos);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		printf("Lista dupla: %ld tarefas (%ld roubadas), %e tarefas/s\n",
+					 processadas, roubos, processadas / segundos(&t1, &t2));
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		processadas = roubo_de_tarefas(&vetor, n_iniciais, profundidade, &roubos);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		printf("Deque em blocos: %ld tarefas (%ld roubadas), %e tarefas/s\n",
+					 processadas, roubos, processadas / segundos(&t1, &t2));
+	}
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -odeque 19-deque.c
+	 ./deque
+*/
+
+/* Exercícios
+
+	 1) Escreva uma função que insere um elemento na posição i do deque,
+	 deslocando os elementos para a ponta mais próxima. Qual é sua
+	 complexidade?
+
+	 2) Por que o deque em blocos não pode ser implementado com um único
+	 vetor circular que cresce com realloc(), como a FilaVetor da aula sobre
+	 pilhas e filas, se quisermos que ponteiros para os elementos continuem
+	 válidos depois de inserções?
+
+	 3) Meça o tempo de roubo_de_tarefas() para blocos de 16, 64, 512 e
+	 4096 elementos.
+*/
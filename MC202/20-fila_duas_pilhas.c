@@ -0,0 +1,426 @@
+/* Fila com duas pilhas
+
+	 O exercício 2 da aula sobre pilhas e filas pede uma fila construída com
+	 duas pilhas. A ideia é usar uma pilha de entrada, onde os elementos são
+	 empilhados quando chegam, e uma pilha de saída, de onde são retirados.
+	 Quando a pilha de saída fica vazia, desempilhamos todos os elementos da
+	 entrada e os empilhamos na saída; isso inverte a ordem deles, e o mais
+	 antigo fica no topo:
+
+	   entrada: [1 2 3 4>      saída: <>
+	   (transfere)
+	   entrada: <>             saída: <4 3 2 1]   (1 está no topo)
+
+	 Cada elemento é transferido uma única vez, de forma que o custo
+	 amortizado de cada operação é O(1). Mas o custo de uma operação
+	 específica pode ser O(n): a remoção que encontra a saída vazia paga pela
+	 transferência de todos os elementos acumulados. Num sistema em que cada
+	 operação tem um prazo (por exemplo, responder a uma requisição em menos
+	 de 1 ms), o que importa é o pior caso, e não a média.
+
+	 Para garantir O(1) no pior caso, fazemos a transferência aos poucos
+	 (reconstrução incremental). Mantemos a regra de que a entrada nunca tem
+	 mais elementos que a saída. Quando a regra seria violada, a entrada
+	 atual é congelada, uma entrada nova e vazia passa a receber os
+	 elementos, e começamos a montar, num vetor novo, a saída futura: os
+	 elementos da entrada congelada, invertidos, embaixo, e os da saída atual
+	 em cima. Cada operação (inserção ou remoção) copia PASSOS_POR_OPERACAO
+	 elementos. Enquanto isso, as remoções continuam sendo feitas no topo da
+	 saída atual; como copiamos a saída atual de baixo para cima, basta parar
+	 a cópia quando ela alcançar o topo. Com 3 passos por operação, a cópia
+	 termina antes que a saída atual se esvazie, e a saída nova assume.
+
+	 Para que nenhuma operação copie O(n) elementos por outro caminho, a
+	 entrada nova já nasce com espaço para todos os elementos que pode
+	 receber até a próxima reconstrução (nunca mais que o tamanho da fila
+	 mais um), e a pilha nunca precisa dobrar com realloc(). Os vetores
+	 liberados ao fim de cada reconstrução (a saída antiga e a entrada
+	 congelada) são guardados e reaproveitados na seguinte. Assim, malloc()
+	 só é chamado quando a fila passa do maior tamanho que já teve, e cada
+	 chamada aloca um vetor sem copiar nada.
+
+	 As pilhas são as pilhas em vetor da aula sobre pilhas e filas. No teste
+	 de desempenho, medimos o tempo de cada operação e comparamos os
+	 percentis 50, 99 e 99,9 e o máximo com os da fila em buffer circular.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CAPACIDADE_INICIAL 16
+
+typedef struct pilhavetor {
+	int n_elementos;
+	int capacidade;
+	int *dados;
+} PilhaVetor;
+
+void inicia_pilha(PilhaVetor *pilha) {
+	pilha->n_elementos = 0;
+	pilha->capacidade = CAPACIDADE_INICIAL;
+	pilha->dados = (int*) malloc(CAPACIDADE_INICIAL * sizeof(int));
+}
+
+void pilha_insere_comeco(PilhaVetor *pilha, int dado) {
+	if (pilha->n_elementos == pilha->capacidade) {
+		pilha->capacidade = 2 * pilha->capacidade;
+		pilha->dados = (int*) realloc(pilha->dados, pilha->capacidade * sizeof(int));
+	}
+	pilha->dados[pilha->n_elementos] = dado;
+	pilha->n_elementos = pilha->n_elementos + 1;
+}
+
+int pilha_retira_comeco(PilhaVetor *pilha, int *dado) {
+	if (pilha->n_elementos == 0) return 0;
+	pilha->n_elementos = pilha->n_elementos - 1;
+	*dado = pilha->dados[pilha->n_elementos];
+	return 1;
+}
+
+/* Fila amortizada */
+typedef struct filaduaspilhas {
+	PilhaVetor entrada;
+	PilhaVetor saida;
+} FilaDuasPilhas;
+
+void inicia_fila_duas_pilhas(FilaDuasPilhas *f) {
+	inicia_pilha(&(f->entrada));
+	inicia_pilha(&(f->saida));
+}
+
+void desaloca_fila_duas_pilhas(FilaDuasPilhas *f) {
+	free(f->entrada.dados);
+	free(f->saida.dados);
+}
+
+void duas_pilhas_insere_final(FilaDuasPilhas *f, int dado) {
+	pilha_insere_comeco(&(f->entrada), dado);
+}
+
+int duas_pilhas_retira_comeco(FilaDuasPilhas *f, int *dado) {
+	int x;
+	if (f->saida.n_elementos == 0)
+		while (pilha_retira_comeco(&(f->entrada), &x))
+			pilha_insere_comeco(&(f->saida), x);
+	return pilha_retira_comeco(&(f->saida), dado);
+}
+
+/* Fila com reconstrução incremental */
+#define PASSOS_POR_OPERACAO 3
+
+typedef struct filaincremental {
+	PilhaVetor entrada;
+	PilhaVetor saida;
+	/* Reconstrução em andamento */
+	int reconstruindo;
+	PilhaVetor congelada; /* Entrada congelada */
+	int *nova; /* Saída em construção */
+	int capacidade_nova;
+	int invertidos; /* Elementos da congelada já copiados para nova */
+	int copiados; /* Elementos da saída já copiados para nova */
+	/* Vetores livres, reaproveitados na próxima reconstrução */
+	int *reserva[2];
+	int capacidade_reserva[2];
+} FilaIncremental;
+
+void inicia_fila_incremental(FilaIncremental *f) {
+	inicia_pilha(&(f->entrada));
+	inicia_pilha(&(f->saida));
+	f->reconstruindo = 0;
+	f->reserva[0] = f->reserva[1] = NULL;
+	f->capacidade_reserva[0] = f->capacidade_reserva[1] = 0;
+}
+
+void desaloca_fila_incremental(FilaIncremental *f) {
+	free(f->entrada.dados);
+	free(f->saida.dados);
+	if (f->reconstruindo) {
+		free(f->congelada.dados);
+		free(f->nova);
+	}
+	free(f->reserva[0]);
+	free(f->reserva[1]);
+}
+
+/* Retorna um vetor com pelo menos "minimo" posições, reaproveitando uma
+	 reserva quando possível. Um vetor novo é alocado com folga, para que
+	 possa ser reaproveitado mesmo que a fila cresça um pouco. */
+int *pega_vetor(FilaIncremental *f, int minimo, int *capacidade) {
+	int i;
+	int *vetor;
+	for (i = 0; i < 2; i++)
+		if (f->capacidade_reserva[i] >= minimo) {
+			vetor = f->reserva[i];
+			*capacidade = f->capacidade_reserva[i];
+			f->reserva[i] = NULL;
+			f->capacidade_reserva[i] = 0;
+			return vetor;
+		}
+	*capacidade = 2 * minimo;
+	return (int *) malloc(*capacidade * sizeof(int));
+}
+
+/* Guarda um vetor livre no lugar da menor reserva */
+void guarda_vetor(FilaIncremental *f, int *vetor, int capacidade) {
+	int i = (f->capacidade_reserva[0] <= f->capacidade_reserva[1]) ? 0 : 1;
+	free(f->reserva[i]);
+	f->reserva[i] = vetor;
+	f->capacidade_reserva[i] = capacidade;
+}
+
+void comeca_reconstrucao(FilaIncremental *f) {
+	int tamanho = f->entrada.n_elementos + f->saida.n_elementos;
+	f->congelada = f->entrada;
+	/* Até a próxima reconstrução, a entrada recebe no máximo tamanho + 1
+		 elementos: durante esta, no máximo um por operação, e depois dela,
+		 no máximo um a mais que a saída, que não cresce. */
+	f->entrada.dados = pega_vetor(f, tamanho + 1, &(f->entrada.capacidade));
+	f->entrada.n_elementos = 0;
+	f->nova = pega_vetor(f, tamanho, &(f->capacidade_nova));
+	f->invertidos = 0;
+	f->copiados = 0;
+	f->reconstruindo = 1;
+}
+
+/* Executa até "passos" cópias. Quando a saída nova fica pronta, ela
+	 substitui a saída atual, e os vetores da saída antiga e da entrada
+	 congelada viram reservas. */
+void reconstroi(FilaIncremental *f, int passos) {
+	PilhaVetor *c = &(f->congelada);
+	int base;
+
+	while ((passos > 0) && (f->invertidos < c->n_elementos)) {
+		f->nova[f->invertidos] = c->dados[c->n_elementos - 1 - f->invertidos];
+		f->invertidos++;
+		passos--;
+	}
+	base = c->n_elementos;
+	while ((passos > 0) && (f->copiados < f->saida.n_elementos)) {
+		f->nova[base + f->copiados] = f->saida.dados[f->copiados];
+		f->copiados++;
+		passos--;
+	}
+	if ((f->invertidos == c->n_elementos) && (f->copiados == f->saida.n_elementos)) {
+		guarda_vetor(f, f->saida.dados, f->saida.capacidade);
+		guarda_vetor(f, c->dados, c->capacidade);
+		f->saida.dados = f->nova;
+		f->saida.capacidade = f->capacidade_nova;
+		f->saida.n_elementos = base + f->copiados;
+		f->reconstruindo = 0;
+	}
+}
+
+/* Depois de cada operação: avança a reconstrução ou, se a entrada ficou
+	 maior que a saída, começa uma nova */
+void verifica_reconstrucao(FilaIncremental *f) {
+	if (f->reconstruindo) reconstroi(f, PASSOS_POR_OPERACAO);
+	else if (f->entrada.n_elementos > f->saida.n_elementos) {
+		comeca_reconstrucao(f);
+		reconstroi(f, PASSOS_POR_OPERACAO);
+	}
+}
+
+void incremental_insere_final(FilaIncremental *f, int dado) {
+	pilha_insere_comeco(&(f->entrada), dado);
+	verifica_reconstrucao(f);
+}
+
+int incremental_retira_comeco(FilaIncremental *f, int *dado) {
+	/* A saída só fica vazia durante uma reconstrução se a fila inteira era
+		 muito pequena quando ela começou; nesse caso, terminamos a cópia. */
+	while (f->reconstruindo && (f->saida.n_elementos == 0))
+		reconstroi(f, PASSOS_POR_OPERACAO);
+	if (!pilha_retira_comeco(&(f->saida), dado)) return 0;
+	/* Se a cópia já tinha alcançado o topo, ela recua junto */
+	if (f->reconstruindo && (f->copiados > f->saida.n_elementos))
+		f->copiados = f->saida.n_elementos;
+	verifica_reconstrucao(f);
+	return 1;
+}
+
+/* Fila em buffer circular, como a FilaVetor da aula sobre pilhas e filas */
+typedef struct filavetor {
+	int n_elementos;
+	unsigned int mascara;
+	unsigned int inicio;
+	int *dados;
+} FilaVetor;
+
+void inicia_fila_vetor(FilaVetor *fila) {
+	fila->n_elementos = 0;
+	fila->mascara = CAPACIDADE_INICIAL - 1;
+	fila->inicio = 0;
+	fila->dados = (int*) malloc(CAPACIDADE_INICIAL * sizeof(int));
+}
+
+void fila_insere_final(FilaVetor *fila, int dado) {
+	unsigned int capacidade, primeira_parte;
+	int *novos_dados;
+	if (fila->n_elementos == (int) (fila->mascara + 1)) {
+		capacidade = fila->mascara + 1;
+		novos_dados = (int*) malloc(2 * capacidade * sizeof(int));
+		primeira_parte = capacidade - (fila->inicio & fila->mascara);
+		memcpy(novos_dados, &(fila->dados[fila->inicio & fila->mascara]),
+					 primeira_parte * sizeof(int));
+		memcpy(&(novos_dados[primeira_parte]), fila->dados,
+					 (capacidade - primeira_parte) * sizeof(int));
+		free(fila->dados);
+		fila->dados = novos_dados;
+		fila->mascara = 2 * capacidade - 1;
+		fila->inicio = 0;
+	}
+	fila->dados[(fila->inicio + fila->n_elementos) & fila->mascara] = dado;
+	fila->n_elementos = fila->n_elementos + 1;
+}
+
+int fila_retira_comeco(FilaVetor *fila, int *dado) {
+	if (fila->n_elementos == 0) return 0;
+	*dado = fila->dados[fila->inicio & fila->mascara];
+	fila->inicio = fila->inicio + 1;
+	fila->n_elementos = fila->n_elementos - 1;
+	return 1;
+}
+
+/* Teste de latência
+
+	 A fila começa com TAMANHO_REGIME elementos e recebe N_OPERACOES
+	 operações, sorteadas entre inserção e remoção com a mesma probabilidade
+	 (a sequência é a mesma para as três filas). O tempo de cada operação é
+	 medido com clock_gettime(), que tem um custo próprio de algumas dezenas
+	 de nanossegundos; esse custo entra em todas as medidas e desloca todos
+	 os percentis igualmente. Os tempos são ordenados para obtermos os
+	 percentis. */
+#define N_OPERACOES 2000000
+
+enum { CIRCULAR, AMORTIZADA, INCREMENTAL };
+const char *nomes[] = {"Buffer circular", "Duas pilhas", "Duas pilhas incremental"};
+
+int compara_longs(const void *a, const void *b) {
+	long x = *(const long *) a, y = *(const long *) b;
+	return (x > y) - (x < y);
+}
+
+long nanossegundos(struct timespec *t) {
+	return t->tv_sec * 1000000000L + t->tv_nsec;
+}
+
+void teste_latencia(int tipo, int tamanho_regime, char operacoes[], long tempos[]) {
+	FilaVetor circular;
+	FilaDuasPilhas amortizada;
+	FilaIncremental incremental;
+	struct timespec t1, t2;
+	unsigned long long verificacao;
+	int i, dado, proximo;
+
+	inicia_fila_vetor(&circular);
+	inicia_fila_duas_pilhas(&amortizada);
+	inicia_fila_incremental(&incremental);
+	proximo = 0;
+	for (i = 0; i < tamanho_regime; i++, proximo++) {
+		if (tipo == CIRCULAR) fila_insere_final(&circular, proximo);
+		else if (tipo == AMORTIZADA) duas_pilhas_insere_final(&amortizada, proximo);
+		else incremental_insere_final(&incremental, proximo);
+	}
+
+	verificacao = 0;
+	for (i = 0; i < N_OPERACOES; i++) {
+		dado = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (operacoes[i]) {
+			if (tipo == CIRCULAR) fila_insere_final(&circular, proximo);
+			else if (tipo == AMORTIZADA) duas_pilhas_insere_final(&amortizada, proximo);
+			else incremental_insere_final(&incremental, proximo);
+		} else {
+			if (tipo == CIRCULAR) fila_retira_comeco(&circular, &dado);
+			else if (tipo == AMORTIZADA) duas_pilhas_retira_comeco(&amortizada, &dado);
+			else incremental_retira_comeco(&incremental, &dado);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		tempos[i] = nanossegundos(&t2) - nanossegundos(&t1);
+		if (operacoes[i]) proximo++;
+		else verificacao = verificacao * 31 + dado;
+	}
+
+	qsort(tempos, N_OPERACOES, sizeof(long), compara_longs);
+	printf("%-24s %8ld %8ld %8ld %8ld   (verificacao = %llu)\n", nomes[tipo],
+				 tempos[N_OPERACOES / 2], tempos[(long) N_OPERACOES * 99 / 100],
+				 tempos[(long) N_OPERACOES * 999 / 1000], tempos[N_OPERACOES - 1],
+				 verificacao);
+
+	free(circular.dados);
+	desaloca_fila_duas_pilhas(&amortizada);
+	desaloca_fila_incremental(&incremental);
+}
+
+int main() {
+	int tamanhos[] = {1000, 100000};
+	FilaDuasPilhas amortizada;
+	FilaIncremental incremental;
+	char *operacoes;
+	long *tempos;
+	int i, j, tipo, d1, d2, erros;
+
+	printf("Inserindo 0 a 9 e retirando:\n");
+	inicia_fila_duas_pilhas(&amortizada);
+	inicia_fila_incremental(&incremental);
+	for (i = 0; i < 10; i++) {
+		duas_pilhas_insere_final(&amortizada, i);
+		incremental_insere_final(&incremental, i);
+	}
+	while (duas_pilhas_retira_comeco(&amortizada, &d1) &&
+				 incremental_retira_comeco(&incremental, &d2))
+		printf("%d %d\n", d1, d2);
+
+	/* Verificação com operações aleatórias */
+	srand(1);
+	erros = 0;
+	j = 0;
+	for (i = 0; i < 1000000; i++) {
+		if (rand() % 5 < 3) {
+			duas_pilhas_insere_final(&amortizada, j);
+			incremental_insere_final(&incremental, j);
+			j++;
+		} else {
+			d1 = duas_pilhas_retira_comeco(&amortizada, &d1) ? d1 : -1;
+			d2 = incremental_retira_comeco(&incremental, &d2) ? d2 : -1;
+			if (d1 != d2) erros++;
+		}
+	}
+	printf("Erros: %d\n", erros);
+	desaloca_fila_duas_pilhas(&amortizada);
+	desaloca_fila_incremental(&incremental);
+
+	operacoes = (char *) malloc(N_OPERACOES);
+	tempos = (long *) malloc(N_OPERACOES * sizeof(long));
+	for (i = 0; i < N_OPERACOES; i++) operacoes[i] = rand() % 2;
+	for (j = 0; j < 2; j++) {
+		printf("---\n%d operacoes, %d elementos na fila, nanossegundos por operacao:\n",
+					 N_OPERACOES, tamanhos[j]);
+		printf("%-24s %8s %8s %8s %8s\n", "", "p50", "p99", "p99.9", "maximo");
+		for (tipo = CIRCULAR; tipo <= INCREMENTAL; tipo++)
+			teste_latencia(tipo, tamanhos[j], operacoes, tempos);
+	}
+	free(operacoes);
+	free(tempos);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -ofila_duas_pilhas 20-fila_duas_pilhas.c
+	 ./fila_duas_pilhas
+*/
+
+/* Exercícios
+
+	 1) Mostre que, com PASSOS_POR_OPERACAO = 3, a cópia sempre termina antes
+	 que a saída atual se esvazie. O que acontece com PASSOS_POR_OPERACAO = 1?
+
+	 2) A fila incremental ainda chama malloc() ao começar uma reconstrução
+	 quando a fila passa do maior tamanho que já teve. Por que essa chamada
+	 também pode causar uma operação lenta? Como evitá-la se o tamanho
+	 máximo da fila for conhecido de antemão?
+
+	 3) Com duas pilhas, também é possível construir um deque. Como?
+*/
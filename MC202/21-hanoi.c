@@ -0,0 +1,353 @@
+/* Torres de Hanoi sem recursão
+
+	 A solução recursiva das Torres de Hanoi (aula de recursão) e a versão com
+	 pilha explícita (aula sobre eliminação de recursão) produzem os
+	 movimentos em ordem, um depois do outro. Para N discos são 2^N - 1
+	 movimentos; com N = 32, são mais de 4 bilhões, e imprimir cada um deles
+	 com printf() produziria dezenas de gigabytes de texto. Nesse tamanho, o
+	 custo de formatar a saída é muito maior que o de calcular os movimentos.
+
+	 Há uma forma de calcular o k-ésimo movimento diretamente, sem gerar os
+	 anteriores. Numerando os movimentos a partir de 1:
+	 * o disco movido no movimento k é o número de zeros no final da
+	   representação binária de k (0 é o menor disco): o menor disco se move
+	   nos movimentos ímpares, o segundo nos movimentos 2, 6, 10, ..., e assim
+	   por diante;
+	 * numerando as torres como 0, 1 e 2, o movimento k vai da torre
+	   (k & (k-1)) % 3 para a torre ((k | (k-1)) + 1) % 3.
+
+	 Com essa fórmula, os discos saem da torre 0 e terminam na torre 2 quando
+	 N é ímpar, ou na torre 1 quando N é par. Para mover de a para b, como nas
+	 outras aulas, basta trocar os nomes das torres.
+
+	 Como cada movimento é calculado de forma independente, podemos:
+	 * gerar qualquer intervalo de movimentos [inicio, fim), e começar do
+	   meio da solução;
+	 * dividir os movimentos entre várias threads, cada uma com seu intervalo;
+	 * escrever os movimentos num vetor fornecido por quem chama a função, em
+	   vez de imprimi-los. Cada movimento ocupa um byte, com a torre de origem
+	   nos bits 2 e 3 e a de destino nos bits 0 e 1.
+
+	 A fórmula ainda custa duas divisões por 3 em cada movimento. Mas, se
+	 escrevermos k = q * 2^B + r, com 0 < r < 2^B, então k & (k-1) é igual a
+	 q * 2^B + (r & (r-1)), e (k | (k-1)) + 1 é igual a q * 2^B + (r | (r-1))
+	 + 1. Ou seja, dentro de um bloco de 2^B movimentos alinhado, a sequência
+	 é sempre a mesma, a menos de uma rotação das torres que depende de
+	 (q * 2^B) % 3. Guardamos as três rotações do padrão de 2^B movimentos, e
+	 gerar um bloco passa a ser uma cópia com memcpy(); só o primeiro
+	 movimento de cada bloco (r = 0, que move um disco grande) usa a fórmula.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_THREADS 64
+#define BLOCO_SAIDA 65536
+
+typedef unsigned char Movimento;
+
+#define ORIGEM(m) ((m) >> 2)
+#define DESTINO(m) ((m) & 3)
+
+/* Traduz o par (origem, destino) da fórmula, com torres 0, 1 e 2, para o
+	 byte do movimento com as torres a, b e c, e guarda as três rotações do
+	 padrão de 2^LOG_PADRAO movimentos */
+#define LOG_PADRAO 16
+#define TAMANHO_PADRAO (1 << LOG_PADRAO)
+#define MASCARA_PADRAO (TAMANHO_PADRAO - 1)
+
+typedef struct tabelahanoi {
+	Movimento codigo[9];
+	Movimento *padrao[3];
+} TabelaHanoi;
+
+void inicia_tabela(TabelaHanoi *tabela, int a, int b, int c, int n) {
+	int torre[3], o, d, s, r;
+	torre[0] = a;
+	torre[(n % 2 == 1) ? 2 : 1] = b;
+	torre[(n % 2 == 1) ? 1 : 2] = c;
+	for (o = 0; o < 3; o++)
+		for (d = 0; d < 3; d++)
+			tabela->codigo[o * 3 + d] = (Movimento) ((torre[o] << 2) | torre[d]);
+	for (s = 0; s < 3; s++) {
+		tabela->padrao[s] = (Movimento *) malloc(TAMANHO_PADRAO);
+		tabela->padrao[s][0] = 0; /* Não é usado */
+		for (r = 1; r < TAMANHO_PADRAO; r++) {
+			o = (s + (r & (r - 1))) % 3;
+			d = (s + (r | (r - 1)) + 1) % 3;
+			tabela->padrao[s][r] = tabela->codigo[o * 3 + d];
+		}
+	}
+}
+
+void desaloca_tabela(TabelaHanoi *tabela) {
+	int s;
+	for (s = 0; s < 3; s++)
+		free(tabela->padrao[s]);
+}
+
+Movimento movimento_hanoi(TabelaHanoi *tabela, unsigned long long k) {
+	return tabela->codigo[((k & (k - 1)) % 3) * 3 + ((k | (k - 1)) + 1) % 3];
+}
+
+/* Escreve em saida[] os movimentos inicio, inicio+1, ..., fim-1, aplicando
+	 a fórmula a cada um */
+void gera_movimentos_formula(TabelaHanoi *tabela, unsigned long long inicio,
+														 unsigned long long fim, Movimento saida[]) {
+	unsigned long long k;
+	for (k = inicio; k < fim; k++)
+		saida[k - inicio] = movimento_hanoi(tabela, k);
+}
+
+/* O mesmo, copiando os trechos dos padrões */
+void gera_movimentos(TabelaHanoi *tabela, unsigned long long inicio,
+										 unsigned long long fim, Movimento saida[]) {
+	unsigned long long k, limite;
+	int r;
+	k = inicio;
+	while (k < fim) {
+		r = (int) (k & MASCARA_PADRAO);
+		if (r == 0) {
+			saida[k - inicio] = movimento_hanoi(tabela, k);
+			k++;
+			continue;
+		}
+		limite = (k | MASCARA_PADRAO) + 1;
+		if (limite > fim) limite = fim;
+		memcpy(&(saida[k - inicio]), &(tabela->padrao[(k & ~(unsigned long long) MASCARA_PADRAO) % 3][r]),
+					 limite - k);
+		k = limite;
+	}
+}
+
+/* Versão recursiva, para comparação, escrevendo no vetor em vez de
+	 imprimir */
+Movimento *hanoi_recursivo(int a, int b, int c, int n, Movimento *saida) {
+	if (n == 1) {
+		*saida = (Movimento) ((a << 2) | b);
+		return saida + 1;
+	}
+	saida = hanoi_recursivo(a, c, b, n - 1, saida);
+	*saida = (Movimento) ((a << 2) | b);
+	return hanoi_recursivo(c, b, a, n - 1, saida + 1);
+}
+
+/* Geração em paralelo. Cada thread gera seu intervalo de movimentos em
+	 blocos de BLOCO_SAIDA bytes, e entrega cada bloco a uma função
+	 consumidora. Aqui, a consumidora só soma os bytes, para que o resultado
+	 possa ser conferido; num programa real, ela poderia gravar o bloco num
+	 arquivo na posição correspondente ao início do intervalo. Como gerar um
+	 bloco é só uma cópia, a vazão aqui é limitada pela consumidora. */
+typedef void (*FuncaoBloco)(Movimento bloco[], int n, void *contexto);
+
+typedef struct tarefa {
+	TabelaHanoi *tabela;
+	unsigned long long inicio, fim;
+	FuncaoBloco consome;
+	unsigned long long soma;
+} Tarefa;
+
+void soma_bloco(Movimento bloco[], int n, void *contexto) {
+	unsigned long long soma = 0;
+	int i;
+	for (i = 0; i < n; i++) soma = soma + bloco[i];
+	*((unsigned long long *) contexto) += soma;
+}
+
+void *executa_tarefa(void *arg) {
+	Tarefa *t = (Tarefa *) arg;
+	Movimento bloco[BLOCO_SAIDA];
+	unsigned long long k, fim;
+	for (k = t->inicio; k < t->fim; k = fim) {
+		fim = (t->fim - k > BLOCO_SAIDA) ? k + BLOCO_SAIDA : t->fim;
+		gera_movimentos(t->tabela, k, fim, bloco);
+		t->consome(bloco, (int) (fim - k), &(t->soma));
+	}
+	return NULL;
+}
+
+unsigned long long hanoi_paralelo(int a, int b, int c, int n, int n_threads) {
+	pthread_t threads[MAX_THREADS];
+	Tarefa tarefas[MAX_THREADS];
+	TabelaHanoi tabela;
+	unsigned long long total = (1ULL << n) - 1, soma = 0;
+	int t;
+	if (n_threads < 1) n_threads = 1;
+	inicia_tabela(&tabela, a, b, c, n);
+	for (t = 0; t < n_threads; t++) {
+		tarefas[t].tabela = &tabela;
+		tarefas[t].inicio = 1 + total * t / n_threads;
+		tarefas[t].fim = 1 + total * (t + 1) / n_threads;
+		tarefas[t].consome = soma_bloco;
+		tarefas[t].soma = 0;
+		if (t > 0) pthread_create(&threads[t], NULL, executa_tarefa, &tarefas[t]);
+	}
+	executa_tarefa(&tarefas[0]);
+	for (t = 1; t < n_threads; t++)
+		pthread_join(threads[t], NULL);
+	for (t = 0; t < n_threads; t++)
+		soma = soma + tarefas[t].soma;
+	desaloca_tabela(&tabela);
+	return soma;
+}
+
+/* Grava todos os movimentos, em binário, na saída padrão */
+void grava_movimentos(int n) {
+	Movimento bloco[BLOCO_SAIDA];
+	TabelaHanoi tabela;
+	unsigned long long k, fim, total = (1ULL << n) - 1;
+	inicia_tabela(&tabela, 1, 2, 3, n);
+	for (k = 1; k <= total; k = fim) {
+		fim = (total + 1 - k > BLOCO_SAIDA) ? k + BLOCO_SAIDA : total + 1;
+		gera_movimentos(&tabela, k, fim, bloco);
+		fwrite(bloco, 1, fim - k, stdout);
+	}
+	desaloca_tabela(&tabela);
+}
+
+int numero_de_threads() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1) return 1;
+	if (n > MAX_THREADS) return MAX_THREADS;
+	return (int) n;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+#define N_VERIFICACAO 20
+#define N_TEXTO 20
+#define N_RECURSIVO 26
+#define N_PARALELO 32
+
+int main(int argc, char *argv[]) {
+	TabelaHanoi tabela;
+	Movimento *recursivo, *direto, *m;
+	struct timespec t1, t2;
+	unsigned long long total, k, inicio, fim, soma, soma_serial;
+	char *texto, *p;
+	int n, a, b, c, erros, n_threads;
+
+	if (argc > 1) {
+		grava_movimentos(atoi(argv[1]));
+		return 0;
+	}
+
+	inicia_tabela(&tabela, 1, 2, 3, 3);
+	printf("3 discos:\n");
+	for (k = 1; k < 8; k++)
+		printf("%d -> %d\n", ORIGEM(movimento_hanoi(&tabela, k)),
+					 DESTINO(movimento_hanoi(&tabela, k)));
+	desaloca_tabela(&tabela);
+
+	/* Verificação: a fórmula e os padrões produzem a mesma sequência que a
+		 recursão, para todas as quantidades de discos e todas as escolhas de
+		 torres, também quando começamos e terminamos no meio da solução */
+	total = (1ULL << N_VERIFICACAO) - 1;
+	recursivo = (Movimento *) malloc(total);
+	direto = (Movimento *) malloc(total);
+	erros = 0;
+	for (n = 1; n <= N_VERIFICACAO; n++)
+		for (a = 1; a <= 3; a++)
+			for (b = 1; b <= 3; b++) {
+				if (a == b) continue;
+				c = 6 - a - b;
+				total = (1ULL << n) - 1;
+				hanoi_recursivo(a, b, c, n, recursivo);
+				inicia_tabela(&tabela, a, b, c, n);
+				gera_movimentos_formula(&tabela, 1, total + 1, direto);
+				if (memcmp(recursivo, direto, total) != 0) erros++;
+				gera_movimentos(&tabela, 1, total + 1, direto);
+				if (memcmp(recursivo, direto, total) != 0) erros++;
+				inicio = total / 3 + 1;
+				fim = total - total / 5 + 1;
+				gera_movimentos(&tabela, inicio, fim, direto);
+				if (memcmp(&(recursivo[inicio - 1]), direto, fim - inicio) != 0) erros++;
+				desaloca_tabela(&tabela);
+			}
+	printf("Erros: %d\n", erros);
+	free(recursivo);
+	free(direto);
+
+	printf("---\nMovimentos por segundo:\n");
+	/* Formatando cada movimento como texto, como faz printf() */
+	total = (1ULL << N_TEXTO) - 1;
+	direto = (Movimento *) malloc(total);
+	texto = (char *) malloc(total * 8);
+	inicia_tabela(&tabela, 1, 2, 3, N_TEXTO);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	gera_movimentos(&tabela, 1, total + 1, direto);
+	for (k = 0, p = texto; k < total; k++)
+		p = p + sprintf(p, "%d -> %d\n", ORIGEM(direto[k]), DESTINO(direto[k]));
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Padroes + texto, N = %d: %e (%ld bytes)\n", N_TEXTO,
+				 total / segundos(&t1, &t2), (long) (p - texto));
+	desaloca_tabela(&tabela);
+	free(texto);
+	free(direto);
+
+	total = (1ULL << N_RECURSIVO) - 1;
+	recursivo = (Movimento *) malloc(total);
+	direto = (Movimento *) malloc(total);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	m = hanoi_recursivo(1, 2, 3, N_RECURSIVO, recursivo);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Recursiva, N = %d: %e\n", N_RECURSIVO,
+				 (m - recursivo) / segundos(&t1, &t2));
+	inicia_tabela(&tabela, 1, 2, 3, N_RECURSIVO);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	gera_movimentos_formula(&tabela, 1, total + 1, direto);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Formula, N = %d: %e\n", N_RECURSIVO, total / segundos(&t1, &t2));
+	if (memcmp(recursivo, direto, total) != 0) printf("Erro!\n");
+	memset(direto, 0, total);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	gera_movimentos(&tabela, 1, total + 1, direto);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("Padroes, N = %d: %e\n", N_RECURSIVO, total / segundos(&t1, &t2));
+	if (memcmp(recursivo, direto, total) != 0) printf("Erro!\n");
+	desaloca_tabela(&tabela);
+	free(recursivo);
+	free(direto);
+
+	/* Em blocos, sem guardar a sequência inteira na memória */
+	total = (1ULL << N_PARALELO) - 1;
+	n_threads = numero_de_threads();
+	soma_serial = 0;
+	for (n = 1; n <= n_threads; n = (n == n_threads) ? n + 1 :
+			 ((2 * n > n_threads) ? n_threads : 2 * n)) {
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		soma = hanoi_paralelo(1, 2, 3, N_PARALELO, n);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		if (n == 1) soma_serial = soma;
+		printf("Padroes em blocos, N = %d, %d thread(s): %e (soma = %llu%s)\n",
+					 N_PARALELO, n, total / segundos(&t1, &t2), soma,
+					 (soma == soma_serial) ? "" : ", ERRO");
+	}
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -ohanoi 21-hanoi.c -pthread
+	 ./hanoi
+	 ./hanoi 20 > movimentos.bin   (grava os movimentos de 20 discos)
+*/
+
+/* Exercícios
+
+	 1) Prove que o disco movido no movimento k é o número de zeros no final
+	 da representação binária de k.
+
+	 2) Nos movimentos ímpares, o menor disco sempre anda para a mesma torre
+	 seguinte (0 -> 2 -> 1 -> 0 ou 0 -> 1 -> 2 -> 0, conforme a paridade de
+	 N). Use isso para gravar os movimentos com menos de um byte cada: quantos
+	 bits são necessários, em média, por movimento?
+
+	 3) Escreva uma função que, dado k, calcula em que torre está cada disco
+	 depois dos k primeiros movimentos, sem gerá-los.
+*/
@@ -0,0 +1,938 @@
+/* Árvores AVL
+
+	 A árvore binária de busca da aula sobre árvores tem operações O(h), onde
+	 h é a altura da árvore. Se os dados chegam em ordem aleatória, h fica
+	 próximo de 2*log2(N). Mas insere_binario() nunca reorganiza a árvore: se
+	 os dados chegam ordenados, como nos itens a) e b) do exercício 2 daquela
+	 aula, cada nó novo vira filho do anterior, a árvore se torna uma lista
+	 ligada, e h = N.
+
+	 Uma árvore AVL (Adelson-Velsky e Landis) é uma árvore binária de busca
+	 que mantém, em todos os nós, a seguinte propriedade:
+
+	   |altura(f_esquerdo) - altura(f_direito)| <= 1
+
+	 Pode-se mostrar que, com isso, a altura nunca passa de 1,44*log2(N+2).
+	 Para manter a propriedade, cada nó guarda a altura da sua sub-árvore, e,
+	 depois de uma inserção ou remoção, os nós no caminho de volta até a raiz
+	 são verificados. Se algum deles ficou desbalanceado (diferença 2), ele é
+	 consertado com rotações, que trocam quem é pai de quem sem alterar a
+	 ordem dos dados:
+
+	          y                          x
+	         / \     rotação à direita  / \
+	        x   C    --------------->  A   y
+	       / \       <---------------     / \
+	      A   B      rotação à esquerda  B   C
+
+	 Em inordem, as duas árvores são A x B y C. Se o lado mais alto de y é o
+	 filho esquerdo x, e o lado mais alto de x também é o esquerdo (A), uma
+	 rotação à direita em y resolve. Se o lado mais alto de x é o direito (B),
+	 primeiro rotacionamos x à esquerda, e depois y à direita (rotação dupla).
+	 O caso do lado direito é simétrico.
+
+	 As funções abaixo têm a mesma forma que as da aula sobre árvores. Uma
+	 diferença é que a árvore AVL não guarda valores repetidos: inserir um
+	 valor que já existe não altera a árvore.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct noavl {
+	int dado;
+	int altura;
+	int tamanho; /* Número de nós da sub-árvore */
+	struct noavl *f_esquerdo;
+	struct noavl *f_direito;
+} NoAVL;
+
+int altura_avl(NoAVL **arvore) {
+	if (*arvore == NULL) return 0;
+	return (*arvore)->altura;
+}
+
+int tamanho_avl(NoAVL **arvore) {
+	if (*arvore == NULL) return 0;
+	return (*arvore)->tamanho;
+}
+
+/* Recalcula a altura e o tamanho do nó a partir dos filhos */
+void atualiza_no(NoAVL *no) {
+	int altura_esq = altura_avl(&(no->f_esquerdo));
+	int altura_dir = altura_avl(&(no->f_direito));
+	no->altura = 1 + ((altura_esq > altura_dir) ? altura_esq : altura_dir);
+	no->tamanho = 1 + tamanho_avl(&(no->f_esquerdo)) + tamanho_avl(&(no->f_direito));
+}
+
+int fator_balanceamento(NoAVL *no) {
+	return altura_avl(&(no->f_esquerdo)) - altura_avl(&(no->f_direito));
+}
+
+void rotaciona_direita(NoAVL **arvore) {
+	NoAVL *y = *arvore;
+	NoAVL *x = y->f_esquerdo;
+	y->f_esquerdo = x->f_direito;
+	x->f_direito = y;
+	atualiza_no(y);
+	atualiza_no(x);
+	*arvore = x;
+}
+
+void rotaciona_esquerda(NoAVL **arvore) {
+	NoAVL *x = *arvore;
+	NoAVL *y = x->f_direito;
+	x->f_direito = y->f_esquerdo;
+	y->f_esquerdo = x;
+	atualiza_no(x);
+	atualiza_no(y);
+	*arvore = y;
+}
+
+/* Recalcula a altura do nó e, se ele ficou desbalanceado, aplica as
+	 rotações */
+void balanceia(NoAVL **arvore) {
+	NoAVL *no = *arvore;
+	int fator = fator_balanceamento(no);
+	if (fator > 1) {
+		if (fator_balanceamento(no->f_esquerdo) < 0)
+			rotaciona_esquerda(&(no->f_esquerdo));
+		rotaciona_direita(arvore);
+	} else if (fator < -1) {
+		if (fator_balanceamento(no->f_direito) > 0)
+			rotaciona_direita(&(no->f_direito));
+		rotaciona_esquerda(arvore);
+	} else {
+		atualiza_no(no);
+	}
+}
+
+/* Retorna 1 se o valor foi inserido e 0 se ele já existia */
+int insere_avl(NoAVL **arvore, int dado) {
+	int inserido;
+	if (*arvore == NULL) {
+		(*arvore) = (NoAVL *) malloc(sizeof(NoAVL));
+		(*arvore)->dado = dado;
+		(*arvore)->altura = 1;
+		(*arvore)->tamanho = 1;
+		(*arvore)->f_esquerdo = NULL;
+		(*arvore)->f_direito = NULL;
+		return 1;
+	}
+	if (dado == (*arvore)->dado) return 0;
+	if (dado > (*arvore)->dado)
+		inserido = insere_avl(&((*arvore)->f_direito), dado);
+	else
+		inserido = insere_avl(&((*arvore)->f_esquerdo), dado);
+	if (inserido) balanceia(arvore);
+	return inserido;
+}
+
+/* Como a altura é O(log N), a busca pode ser um laço simples */
+int busca_avl(NoAVL **arvore, int valor) {
+	NoAVL *no = *arvore;
+	while (no != NULL) {
+		if (valor == no->dado) return 1;
+		no = (valor < no->dado) ? no->f_esquerdo : no->f_direito;
+	}
+	return 0;
+}
+
+NoAVL **minimo_avl(NoAVL **arvore) {
+	if (*arvore == NULL) return NULL;
+	while ((*arvore)->f_esquerdo != NULL)
+		arvore = &((*arvore)->f_esquerdo);
+	return arvore;
+}
+
+/* Remove o nó de valor mínimo da árvore, rebalanceando o caminho, e
+	 devolve o nó sem liberá-lo */
+NoAVL *retira_minimo_avl(NoAVL **arvore) {
+	NoAVL *minimo;
+	if ((*arvore)->f_esquerdo == NULL) {
+		minimo = *arvore;
+		*arvore = minimo->f_direito;
+		return minimo;
+	}
+	minimo = retira_minimo_avl(&((*arvore)->f_esquerdo));
+	balanceia(arvore);
+	return minimo;
+}
+
+/* Retorna 1 se o valor foi removido e 0 se ele não existia. Um nó com dois
+	 filhos é substituído pelo mínimo do seu filho direito, como na aula
+	 sobre árvores */
+int remove_avl(NoAVL **arvore, int valor) {
+	NoAVL *no = *arvore, *sucessor;
+	int removido;
+	if (no == NULL) return 0;
+	if (valor < no->dado) {
+		removido = remove_avl(&(no->f_esquerdo), valor);
+	} else if (valor > no->dado) {
+		removido = remove_avl(&(no->f_direito), valor);
+	} else {
+		if (no->f_esquerdo == NULL) {
+			*arvore = no->f_direito;
+		} else if (no->f_direito == NULL) {
+			*arvore = no->f_esquerdo;
+		} else {
+			sucessor = retira_minimo_avl(&(no->f_direito));
+			sucessor->f_esquerdo = no->f_esquerdo;
+			sucessor->f_direito = no->f_direito;
+			*arvore = sucessor;
+		}
+		free(no);
+		if (*arvore == NULL) return 1;
+		removido = 1;
+	}
+	if (removido) balanceia(arvore);
+	return removido;
+}
+
+void imprime_ordenado_avl(NoAVL **arvore) {
+	if ((*arvore) != NULL) {
+		imprime_ordenado_avl(&((*arvore)->f_esquerdo));
+		printf("\t%d\t", (*arvore)->dado);
+		imprime_ordenado_avl(&((*arvore)->f_direito));
+	}
+}
+
+void imprime_preordem_avl(NoAVL **arvore) {
+	if ((*arvore) != NULL) {
+		printf("\t%d\t", (*arvore)->dado);
+		imprime_preordem_avl(&((*arvore)->f_esquerdo));
+		imprime_preordem_avl(&((*arvore)->f_direito));
+	}
+}
+
+/* Retorna o número de nós liberados */
+int desaloca_avl(NoAVL **arvore) {
+	int n = 0;
+	if (*arvore != NULL) {
+		n = desaloca_avl(&(*arvore)->f_esquerdo);
+		n = n + desaloca_avl(&(*arvore)->f_direito);
+		free(*arvore);
+		*arvore = NULL;
+		n = n + 1;
+	}
+	return n;
+}
+
+/* Remoção em intervalos e em lotes
+
+	 Para remover todos os valores de um intervalo [minimo, maximo], poderíamos
+	 chamar remove_avl() para cada um deles, com custo O(k log N) para k
+	 valores removidos. Podemos fazer melhor com duas operações auxiliares:
+
+	 * junta(esq, meio, dir): recebe duas árvores AVL, com todos os valores
+	   de esq menores que meio->dado e todos os de dir maiores, e devolve uma
+	   árvore AVL com todos eles. Se as alturas são parecidas, meio vira a
+	   raiz; senão, descemos pela borda da árvore mais alta até encontrar uma
+	   sub-árvore da altura da outra, penduramos meio ali, e rebalanceamos o
+	   caminho de volta. O custo é O(|altura(esq) - altura(dir)| + 1).
+
+	 * divide(arvore, x, &menores, &maiores): separa a árvore em duas, uma com
+	   os valores menores que x e outra com os maiores, e devolve o nó de valor
+	   x, se existir. Descendo pelo caminho de busca de x, cada nó visitado e
+	   a sub-árvore do lado oposto são juntados ao resultado correspondente.
+	   A soma dos custos das junções é O(log N).
+
+	 Com isso, remover o intervalo é dividir em minimo, dividir a parte maior
+	 em maximo, liberar a parte do meio em O(k), e juntar as duas pontas:
+	 O(k + log N) no total.
+
+	 Para remover um lote de k valores ordenados, descemos pela árvore
+	 dividindo o lote: em cada nó, os valores menores que o do nó vão para a
+	 esquerda, e os maiores, para a direita. Sub-árvores que não recebem
+	 nenhum valor não são visitadas. Na volta, o nó é juntado às suas
+	 sub-árvores (que podem ter perdido altura) com junta(), ou, se seu valor
+	 estava no lote, as sub-árvores são juntadas sem ele. O custo é
+	 O(k log(N/k + 1)): O(log N) se o lote é pequeno, e O(N) se o lote tem
+	 quase todos os valores, em vez de O(k log N).
+*/
+NoAVL *junta(NoAVL *esq, NoAVL *meio, NoAVL *dir) {
+	int altura_esq = altura_avl(&esq), altura_dir = altura_avl(&dir);
+	if (altura_esq > altura_dir + 1) {
+		esq->f_direito = junta(esq->f_direito, meio, dir);
+		balanceia(&esq);
+		return esq;
+	}
+	if (altura_dir > altura_esq + 1) {
+		dir->f_esquerdo = junta(esq, meio, dir->f_esquerdo);
+		balanceia(&dir);
+		return dir;
+	}
+	meio->f_esquerdo = esq;
+	meio->f_direito = dir;
+	atualiza_no(meio);
+	return meio;
+}
+
+/* Junta duas árvores sem um nó do meio: usa o mínimo da direita */
+NoAVL *junta_sem_meio(NoAVL *esq, NoAVL *dir) {
+	NoAVL *meio;
+	if (dir == NULL) return esq;
+	meio = retira_minimo_avl(&dir);
+	return junta(esq, meio, dir);
+}
+
+NoAVL *divide(NoAVL *arvore, int x, NoAVL **menores, NoAVL **maiores) {
+	NoAVL *encontrado, *resto;
+	if (arvore == NULL) {
+		*menores = NULL;
+		*maiores = NULL;
+		return NULL;
+	}
+	if (x == arvore->dado) {
+		*menores = arvore->f_esquerdo;
+		*maiores = arvore->f_direito;
+		return arvore;
+	}
+	if (x < arvore->dado) {
+		encontrado = divide(arvore->f_esquerdo, x, menores, &resto);
+		*maiores = junta(resto, arvore, arvore->f_direito);
+	} else {
+		encontrado = divide(arvore->f_direito, x, &resto, maiores);
+		*menores = junta(arvore->f_esquerdo, arvore, resto);
+	}
+	return encontrado;
+}
+
+/* Remove todos os valores v com minimo <= v <= maximo. Retorna o número
+	 de valores removidos */
+int remove_intervalo(NoAVL **arvore, int minimo, int maximo) {
+	NoAVL *menores, *meio, *maiores, *no;
+	int removidos = 0;
+	if (minimo > maximo) return 0;
+	no = divide(*arvore, minimo, &menores, &meio);
+	if (no != NULL) {
+		free(no);
+		removidos++;
+	}
+	no = divide(meio, maximo, &meio, &maiores);
+	if (no != NULL) {
+		free(no);
+		removidos++;
+	}
+	removidos = removidos + desaloca_avl(&meio);
+	*arvore = junta_sem_meio(menores, maiores);
+	return removidos;
+}
+
+/* Remove os valores de chaves[0..n-1], que devem estar em ordem crescente.
+	 Retorna o número de valores removidos */
+int remove_lote(NoAVL **arvore, int chaves[], int n) {
+	NoAVL *no = *arvore;
+	int inicio, fim, meio, achou, removidos;
+	if ((no == NULL) || (n == 0)) return 0;
+	/* Busca binária: chaves[0..inicio-1] são menores que no->dado */
+	inicio = 0;
+	fim = n;
+	while (inicio < fim) {
+		meio = (inicio + fim) / 2;
+		if (chaves[meio] < no->dado) inicio = meio + 1;
+		else fim = meio;
+	}
+	achou = (inicio < n) && (chaves[inicio] == no->dado);
+	removidos = remove_lote(&(no->f_esquerdo), chaves, inicio);
+	removidos = removidos + remove_lote(&(no->f_direito), &(chaves[inicio + achou]),
+																			n - inicio - achou);
+	if (achou) {
+		*arvore = junta_sem_meio(no->f_esquerdo, no->f_direito);
+		free(no);
+		return removidos + 1;
+	}
+	*arvore = junta(no->f_esquerdo, no, no->f_direito);
+	return removidos;
+}
+
+/* Estatísticas de ordem
+
+	 Cada nó também guarda o tamanho da sua sub-árvore, que é atualizado
+	 junto com a altura, por atualiza_no(), em todas as operações que mudam a
+	 árvore (inserção, remoção, rotações e junções). Com isso, perguntas sobre
+	 a posição dos valores na ordem crescente podem ser respondidas descendo
+	 um único caminho, em O(log N), em vez de percorrer a árvore em inordem:
+
+	 * posto(x): quantos valores são menores que x. Ao descer para a direita
+	   de um nó, todos os valores da sua sub-árvore esquerda, e ele próprio,
+	   são menores que x;
+	 * seleciona(k): o k-ésimo menor valor (k = 0 é o mínimo). Se a
+	   sub-árvore esquerda tem e nós, o valor procurado está nela (k < e), é
+	   o próprio nó (k == e), ou é o (k-e-1)-ésimo da sub-árvore direita;
+	 * conta_intervalo(minimo, maximo): posto(maximo) - posto(minimo), mais um
+	   se maximo está na árvore;
+	 * um iterador que percorre, em lotes, os valores de um intervalo,
+	   começando no menor valor >= minimo, como os iteradores da aula sobre
+	   percursos em árvores. A pilha guarda, no máximo, a altura da árvore.
+*/
+int posto(NoAVL **arvore, int x) {
+	NoAVL *no = *arvore;
+	int menores = 0;
+	while (no != NULL) {
+		if (no->dado < x) {
+			menores = menores + tamanho_avl(&(no->f_esquerdo)) + 1;
+			no = no->f_direito;
+		} else {
+			no = no->f_esquerdo;
+		}
+	}
+	return menores;
+}
+
+/* Retorna o nó do k-ésimo menor valor, ou NULL se k está fora de
+	 [0, tamanho - 1] */
+NoAVL *seleciona(NoAVL **arvore, int k) {
+	NoAVL *no = *arvore;
+	int e;
+	if (k < 0) return NULL;
+	while (no != NULL) {
+		e = tamanho_avl(&(no->f_esquerdo));
+		if (k < e) {
+			no = no->f_esquerdo;
+		} else if (k == e) {
+			return no;
+		} else {
+			k = k - e - 1;
+			no = no->f_direito;
+		}
+	}
+	return NULL;
+}
+
+int conta_intervalo(NoAVL **arvore, int minimo, int maximo) {
+	if (minimo > maximo) return 0;
+	return posto(arvore, maximo) - posto(arvore, minimo) + busca_avl(arvore, maximo);
+}
+
+/* A altura de uma árvore AVL com menos de 2^31 nós é menor que 46 */
+#define MAX_ALTURA 64
+
+typedef struct iteradorintervalo {
+	NoAVL *pilha[MAX_ALTURA];
+	int topo;
+	int maximo;
+} IteradorIntervalo;
+
+void inicia_intervalo(IteradorIntervalo *it, NoAVL **arvore, int minimo, int maximo) {
+	NoAVL *no = *arvore;
+	it->topo = 0;
+	it->maximo = maximo;
+	/* Empilha os nós do caminho até minimo em que descemos para a esquerda:
+		 são os valores >= minimo cuja sub-árvore esquerda ainda falta */
+	while (no != NULL) {
+		if (no->dado >= minimo) {
+			it->pilha[it->topo++] = no;
+			no = no->f_esquerdo;
+		} else {
+			no = no->f_direito;
+		}
+	}
+}
+
+/* Escreve até max valores do intervalo em saida[], em ordem crescente, e
+	 retorna quantos foram escritos; 0 indica que o intervalo terminou */
+int proximos_intervalo(IteradorIntervalo *it, int saida[], int max) {
+	NoAVL *no;
+	int n = 0;
+	while ((n < max) && (it->topo > 0)) {
+		no = it->pilha[--it->topo];
+		if (no->dado > it->maximo) {
+			it->topo = 0;
+			break;
+		}
+		saida[n++] = no->dado;
+		for (no = no->f_direito; no != NULL; no = no->f_esquerdo)
+			it->pilha[it->topo++] = no;
+	}
+	return n;
+}
+
+/* Verifica a ordem, as alturas e tamanhos guardados e o balanceamento.
+	 Retorna o número de nós, ou -1 se encontrou algum erro */
+int verifica_avl(NoAVL **arvore, long minimo, long maximo) {
+	NoAVL *no = *arvore;
+	int n_esq, n_dir, fator, altura, tamanho;
+	if (no == NULL) return 0;
+	if ((no->dado < minimo) || (no->dado > maximo)) return -1;
+	n_esq = verifica_avl(&(no->f_esquerdo), minimo, (long) no->dado - 1);
+	n_dir = verifica_avl(&(no->f_direito), (long) no->dado + 1, maximo);
+	if ((n_esq < 0) || (n_dir < 0)) return -1;
+	fator = fator_balanceamento(no);
+	if ((fator > 1) || (fator < -1)) return -1;
+	altura = no->altura;
+	tamanho = no->tamanho;
+	atualiza_no(no);
+	if ((no->altura != altura) || (no->tamanho != tamanho)) return -1;
+	return n_esq + n_dir + 1;
+}
+
+/* Árvore binária de busca da aula sobre árvores, para comparação. A inserção
+	 e a altura são escritas sem recursão, porque, com dados ordenados, a
+	 árvore tem altura N e a recursão estouraria a pilha de chamadas. */
+typedef struct noarvore {
+	int dado;
+	struct noarvore *f_esquerdo;
+	struct noarvore *f_direito;
+} NoArvore;
+
+void insere_binario(NoArvore **arvore, int dado) {
+	while (*arvore != NULL) {
+		if (dado >= (*arvore)->dado) arvore = &((*arvore)->f_direito);
+		else arvore = &((*arvore)->f_esquerdo);
+	}
+	(*arvore) = (NoArvore *) malloc(sizeof(NoArvore));
+	(*arvore)->dado = dado;
+	(*arvore)->f_esquerdo = NULL;
+	(*arvore)->f_direito = NULL;
+}
+
+int busca(NoArvore **arvore, int valor) {
+	NoArvore *no = *arvore;
+	while (no != NULL) {
+		if (valor == no->dado) return 1;
+		no = (valor < no->dado) ? no->f_esquerdo : no->f_direito;
+	}
+	return 0;
+}
+
+/* Altura e desalocação percorrendo a árvore nível por nível, com uma fila
+	 em vetor */
+int altura_e_desaloca(NoArvore **arvore, int n) {
+	NoArvore **fila;
+	int inicio, final, fim_do_nivel, altura;
+	if (*arvore == NULL) return 0;
+	fila = (NoArvore **) malloc(n * sizeof(NoArvore *));
+	inicio = 0;
+	final = 0;
+	fila[final++] = *arvore;
+	altura = 0;
+	while (inicio < final) {
+		fim_do_nivel = final;
+		altura++;
+		while (inicio < fim_do_nivel) {
+			if (fila[inicio]->f_esquerdo != NULL) fila[final++] = fila[inicio]->f_esquerdo;
+			if (fila[inicio]->f_direito != NULL) fila[final++] = fila[inicio]->f_direito;
+			inicio++;
+		}
+	}
+	for (inicio = 0; inicio < final; inicio++) free(fila[inicio]);
+	free(fila);
+	*arvore = NULL;
+	return altura;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+/* Teste de desempenho: insere N chaves distintas em ordem crescente,
+	 decrescente ou aleatória, e depois busca todas, em ordem aleatória. Na
+	 árvore sem balanceamento, as ordens crescente e decrescente custam
+	 O(N^2); por isso, nesses casos, ela é testada com N_DEGENERADO chaves.
+	 Com 10^6 chaves, o tempo seria (10^6 / N_DEGENERADO)^2 vezes maior. */
+#define N_CHAVES 1000000
+#define N_DEGENERADO 20000
+
+enum { CRESCENTE, DECRESCENTE, ALEATORIA };
+const char *nomes_ordens[] = {"crescente", "decrescente", "aleatoria"};
+
+void embaralha(int v[], int n) {
+	int i, j, t;
+	for (i = n - 1; i > 0; i--) {
+		j = (int) ((((unsigned long) rand() << 15) ^ (unsigned long) rand()) % (i + 1));
+		t = v[i];
+		v[i] = v[j];
+		v[j] = t;
+	}
+}
+
+void teste_desempenho(int ordem, int n, int *chaves, int *consultas, int avl) {
+	NoAVL *arvore_avl = NULL;
+	NoArvore *arvore = NULL;
+	struct timespec t1, t2, t3;
+	int i, encontrados, altura;
+
+	for (i = 0; i < n; i++) {
+		chaves[i] = (ordem == DECRESCENTE) ? 2 * (n - 1 - i) : 2 * i;
+		consultas[i] = 2 * i;
+	}
+	if (ordem == ALEATORIA) embaralha(chaves, n);
+	embaralha(consultas, n);
+
+	encontrados = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (avl) for (i = 0; i < n; i++) insere_avl(&arvore_avl, chaves[i]);
+	else for (i = 0; i < n; i++) insere_binario(&arvore, chaves[i]);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	if (avl) for (i = 0; i < n; i++) encontrados += busca_avl(&arvore_avl, consultas[i]);
+	else for (i = 0; i < n; i++) encontrados += busca(&arvore, consultas[i]);
+	clock_gettime(CLOCK_MONOTONIC, &t3);
+
+	if (avl) {
+		altura = altura_avl(&arvore_avl);
+		if (verifica_avl(&arvore_avl, -1, 2L * n) != n) printf("Erro!\n");
+		desaloca_avl(&arvore_avl);
+	} else {
+		altura = altura_e_desaloca(&arvore, n);
+	}
+	printf("%-13s %-12s %8d %8d %14e %14e%s\n", avl ? "AVL" : "Sem balanco",
+				 nomes_ordens[ordem], n, altura, n / segundos(&t1, &t2),
+				 n / segundos(&t2, &t3), (encontrados == n) ? "" : " ERRO");
+}
+
+/* Teste aleatório: N_OPERACOES_TESTE inserções, remoções, buscas, remoções
+	 de intervalos e de lotes, com valores entre 0 e UNIVERSO-1. Um vetor
+	 presente[] diz quais valores deveriam estar na árvore. A cada
+	 INTERVALO_VERIFICACAO operações, verifica_avl() confere a ordem, o
+	 balanceamento e o número de nós. */
+#define N_OPERACOES_TESTE 10000000
+#define UNIVERSO 65536
+#define INTERVALO_VERIFICACAO 100000
+#define MAX_LOTE 32
+
+int compara_ints(const void *a, const void *b) {
+	int x = *(const int *) a, y = *(const int *) b;
+	return (x > y) - (x < y);
+}
+
+/* Confere posto(), seleciona(), conta_intervalo() e o iterador de
+	 intervalo com N_CONSULTAS_TESTE consultas sorteadas, varrendo presente[]
+	 para obter as respostas esperadas. Retorna o número de erros. */
+#define N_CONSULTAS_TESTE 10
+
+long verifica_estatisticas(NoAVL **arvore, char presente[], int n) {
+	IteradorIntervalo it;
+	NoAVL *no;
+	int saida[64], i, j, k, m, x, maximo, esperado, recebidos;
+	long erros = 0;
+	for (i = 0; i < N_CONSULTAS_TESTE; i++) {
+		x = rand() % UNIVERSO;
+		for (j = 0, esperado = 0; j < x; j++) esperado = esperado + presente[j];
+		if (posto(arvore, x) != esperado) erros++;
+
+		k = rand() % (n + 1); /* k == n não existe */
+		no = seleciona(arvore, k);
+		for (j = 0; (j < UNIVERSO) && (k >= presente[j]); j++) k = k - presente[j];
+		if ((j == UNIVERSO) ? (no != NULL) : ((no == NULL) || (no->dado != j))) erros++;
+
+		maximo = x + rand() % 256;
+		for (j = x, esperado = 0; (j <= maximo) && (j < UNIVERSO); j++)
+			esperado = esperado + presente[j];
+		if (conta_intervalo(arvore, x, maximo) != esperado) erros++;
+
+		/* O iterador, em lotes de 64, entrega os mesmos valores, em ordem */
+		inicia_intervalo(&it, arvore, x, maximo);
+		j = x;
+		recebidos = 0;
+		while ((k = proximos_intervalo(&it, saida, 64)) > 0) {
+			for (m = 0; m < k; m++) {
+				while ((j < UNIVERSO) && !presente[j]) j++;
+				if ((j >= UNIVERSO) || (saida[m] != j)) erros++;
+				j++;
+			}
+			recebidos = recebidos + k;
+		}
+		if (recebidos != esperado) erros++;
+	}
+	return erros;
+}
+
+long teste_aleatorio() {
+	NoAVL *arvore = NULL;
+	char *presente;
+	int lote[MAX_LOTE];
+	long i, erros;
+	int j, k, n, operacao, valor, maximo, esperado;
+
+	presente = (char *) calloc(UNIVERSO, 1);
+	n = 0;
+	erros = 0;
+	for (i = 1; i <= N_OPERACOES_TESTE; i++) {
+		operacao = rand() % 100;
+		valor = rand() % UNIVERSO;
+		if (operacao < 40) {
+			if (insere_avl(&arvore, valor) != !presente[valor]) erros++;
+			if (!presente[valor]) n++;
+			presente[valor] = 1;
+		} else if (operacao < 75) {
+			if (remove_avl(&arvore, valor) != presente[valor]) erros++;
+			if (presente[valor]) n--;
+			presente[valor] = 0;
+		} else if (operacao < 95) {
+			if (busca_avl(&arvore, valor) != presente[valor]) erros++;
+		} else if (operacao < 98) {
+			maximo = valor + rand() % 64;
+			if (maximo >= UNIVERSO) maximo = UNIVERSO - 1;
+			esperado = 0;
+			for (j = valor; j <= maximo; j++) {
+				esperado = esperado + presente[j];
+				presente[j] = 0;
+			}
+			if (remove_intervalo(&arvore, valor, maximo) != esperado) erros++;
+			n = n - esperado;
+		} else {
+			k = 1 + rand() % MAX_LOTE;
+			for (j = 0; j < k; j++) lote[j] = rand() % UNIVERSO;
+			qsort(lote, k, sizeof(int), compara_ints);
+			/* Sem repetições */
+			for (j = 1, maximo = 1; j < k; j++)
+				if (lote[j] != lote[maximo - 1]) lote[maximo++] = lote[j];
+			k = maximo;
+			esperado = 0;
+			for (j = 0; j < k; j++) {
+				esperado = esperado + presente[lote[j]];
+				presente[lote[j]] = 0;
+			}
+			if (remove_lote(&arvore, lote, k) != esperado) erros++;
+			n = n - esperado;
+		}
+		if (i % INTERVALO_VERIFICACAO == 0) {
+			if (verifica_avl(&arvore, 0, UNIVERSO - 1) != n) erros++;
+			erros = erros + verifica_estatisticas(&arvore, presente, n);
+		}
+	}
+	printf("%d operacoes, %d valores na arvore no final, altura %d\n",
+				 N_OPERACOES_TESTE, n, altura_avl(&arvore));
+	desaloca_avl(&arvore);
+	free(presente);
+	return erros;
+}
+
+/* Consultas por segundo, comparando as estatísticas de ordem com
+	 percursos completos em inordem, como imprime_ordenado(), que contam os
+	 valores até encontrar a resposta. Os percursos são O(N) e, por isso,
+	 são medidos com apenas N_VARREDURAS consultas. */
+#define N_CONSULTAS_ESTATISTICAS 1000000
+#define N_VARREDURAS 20
+#define TAMANHO_INTERVALO 1000
+
+int posto_varredura(NoAVL *no, int x) {
+	if (no == NULL) return 0;
+	return posto_varredura(no->f_esquerdo, x) + (no->dado < x) +
+		posto_varredura(no->f_direito, x);
+}
+
+/* Percorre em inordem, decrementando *k; devolve o nó em que *k chega a 0 */
+NoAVL *seleciona_varredura(NoAVL *no, int *k) {
+	NoAVL *encontrado;
+	if (no == NULL) return NULL;
+	encontrado = seleciona_varredura(no->f_esquerdo, k);
+	if (encontrado != NULL) return encontrado;
+	if (*k == 0) return no;
+	*k = *k - 1;
+	return seleciona_varredura(no->f_direito, k);
+}
+
+int conta_intervalo_varredura(NoAVL *no, int minimo, int maximo) {
+	if (no == NULL) return 0;
+	return conta_intervalo_varredura(no->f_esquerdo, minimo, maximo) +
+		((no->dado >= minimo) && (no->dado <= maximo)) +
+		conta_intervalo_varredura(no->f_direito, minimo, maximo);
+}
+
+long long soma_intervalo_varredura(NoAVL *no, int minimo, int maximo) {
+	if (no == NULL) return 0;
+	return soma_intervalo_varredura(no->f_esquerdo, minimo, maximo) +
+		(((no->dado >= minimo) && (no->dado <= maximo)) ? no->dado : 0) +
+		soma_intervalo_varredura(no->f_direito, minimo, maximo);
+}
+
+enum { POSTO, SELECIONA, CONTA_INTERVALO, INTERVALO };
+
+/* Responde uma consulta com a árvore ou com uma varredura. Para o
+	 intervalo, retorna a soma dos valores percorridos. */
+long long consulta(NoAVL **arvore, int tipo, int x, int varredura) {
+	IteradorIntervalo it;
+	int saida[256], i, n, k;
+	long long soma;
+	if (tipo == POSTO)
+		return varredura ? posto_varredura(*arvore, x) : posto(arvore, x);
+	if (tipo == SELECIONA) {
+		k = x / 2;
+		return varredura ? seleciona_varredura(*arvore, &k)->dado : seleciona(arvore, k)->dado;
+	}
+	if (tipo == CONTA_INTERVALO)
+		return varredura ? conta_intervalo_varredura(*arvore, x, x + TAMANHO_INTERVALO) :
+			conta_intervalo(arvore, x, x + TAMANHO_INTERVALO);
+	if (varredura) return soma_intervalo_varredura(*arvore, x, x + TAMANHO_INTERVALO);
+	soma = 0;
+	inicia_intervalo(&it, arvore, x, x + TAMANHO_INTERVALO);
+	while ((n = proximos_intervalo(&it, saida, 256)) > 0)
+		for (i = 0; i < n; i++) soma = soma + saida[i];
+	return soma;
+}
+
+void teste_estatisticas(int *chaves, int *consultas) {
+	NoAVL *arvore = NULL;
+	struct timespec t1, t2;
+	long long soma_arvore, soma_varredura;
+	double taxa_arvore, taxa_varredura;
+	int i, tipo;
+	const char *nomes[] = {"posto", "seleciona", "conta_intervalo", "intervalo"};
+	/* O vetor de consultas tem N_CHAVES posições */
+	int n_consultas = (N_CONSULTAS_ESTATISTICAS < N_CHAVES) ?
+		N_CONSULTAS_ESTATISTICAS : N_CHAVES;
+
+	for (i = 0; i < N_CHAVES; i++) {
+		chaves[i] = 2 * i;
+		consultas[i] = (int) ((((unsigned long) rand() << 15) ^ (unsigned long) rand()) %
+													(2 * N_CHAVES));
+	}
+	embaralha(chaves, N_CHAVES);
+	for (i = 0; i < N_CHAVES; i++) insere_avl(&arvore, chaves[i]);
+	printf("%-16s %16s %16s\n", "Consulta", "Arvore (por s)", "Inordem (por s)");
+	for (tipo = POSTO; tipo <= INTERVALO; tipo++) {
+		/* As respostas das N_VARREDURAS primeiras consultas são comparadas */
+		soma_arvore = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		for (i = 0; i < n_consultas; i++) {
+			if (i == N_VARREDURAS) soma_varredura = soma_arvore;
+			soma_arvore = soma_arvore + consulta(&arvore, tipo, consultas[i], 0);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		taxa_arvore = n_consultas / segundos(&t1, &t2);
+		soma_arvore = soma_varredura;
+		soma_varredura = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		for (i = 0; i < N_VARREDURAS; i++)
+			soma_varredura = soma_varredura + consulta(&arvore, tipo, consultas[i], 1);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		taxa_varredura = N_VARREDURAS / segundos(&t1, &t2);
+		printf("%-16s %16e %16e%s\n", nomes[tipo], taxa_arvore, taxa_varredura,
+					 (soma_arvore == soma_varredura) ? "" : " ERRO");
+	}
+	desaloca_avl(&arvore);
+}
+
+/* Remoções por segundo: N_REMOVIDOS valores, em intervalos de tamanho_lote
+	 valores consecutivos, ou em lotes de tamanho_lote valores sorteados,
+	 comparando com remove_avl() para cada valor */
+#define N_REMOVIDOS 200000
+
+void teste_remocao(int *chaves, int tamanho_lote) {
+	NoAVL *arvore;
+	struct timespec t1, t2;
+	int i, j, removidos, modo;
+	const char *nomes[] = {"remove_avl, intervalo", "remove_intervalo",
+												 "remove_avl, sorteados", "remove_lote"};
+
+	for (modo = 0; modo < 4; modo++) {
+		arvore = NULL;
+		for (i = 0; i < N_CHAVES; i++) chaves[i] = i;
+		embaralha(chaves, N_CHAVES);
+		for (i = 0; i < N_CHAVES; i++) insere_avl(&arvore, chaves[i]);
+		/* Os primeiros N_REMOVIDOS valores embaralhados, em lotes ordenados */
+		for (i = 0; i < N_REMOVIDOS; i += tamanho_lote)
+			qsort(&(chaves[i]), tamanho_lote, sizeof(int), compara_ints);
+		removidos = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		for (i = 0; i < N_REMOVIDOS; i += tamanho_lote) {
+			if (modo == 0)
+				for (j = 0; j < tamanho_lote; j++) removidos += remove_avl(&arvore, 2 * i + j);
+			else if (modo == 1)
+				removidos += remove_intervalo(&arvore, 2 * i, 2 * i + tamanho_lote - 1);
+			else if (modo == 2)
+				for (j = 0; j < tamanho_lote; j++) removidos += remove_avl(&arvore, chaves[i + j]);
+			else
+				removidos += remove_lote(&arvore, &(chaves[i]), tamanho_lote);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		printf("%-24s %8d removidos, %e remocoes/s%s\n", nomes[modo], removidos,
+					 removidos / segundos(&t1, &t2),
+					 (verifica_avl(&arvore, 0, N_CHAVES) == N_CHAVES - removidos) ? "" : " ERRO");
+		desaloca_avl(&arvore);
+	}
+}
+
+int main() {
+	int crescente[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	int decrescente[8] = {8, 7, 6, 5, 4, 3, 2, 1};
+	int vetor[10] = {5, 2, 7, 3, 4, 17, 6, 12, 11, 10};
+	NoAVL *arvore;
+	int *chaves, *consultas;
+	int i, ordem, n;
+
+	arvore = NULL;
+	for (i = 0; i < 8; i++) insere_avl(&arvore, crescente[i]);
+	printf("{1, ..., 8}: altura %d, preordem:", altura_avl(&arvore));
+	imprime_preordem_avl(&arvore);
+	printf("\n");
+	desaloca_avl(&arvore);
+
+	arvore = NULL;
+	for (i = 0; i < 8; i++) insere_avl(&arvore, decrescente[i]);
+	printf("{8, ..., 1}: altura %d, preordem:", altura_avl(&arvore));
+	imprime_preordem_avl(&arvore);
+	printf("\n");
+	desaloca_avl(&arvore);
+
+	arvore = NULL;
+	for (i = 0; i < 10; i++) insere_avl(&arvore, vetor[i]);
+	imprime_ordenado_avl(&arvore);
+	printf("\nAltura da arvore: %d\n", altura_avl(&arvore));
+	printf("Busca por valor 7: %d\n", busca_avl(&arvore, 7));
+	printf("Busca por valor 50: %d\n", busca_avl(&arvore, 50));
+	printf("Minimo da arvore: %d\n", (*minimo_avl(&arvore))->dado);
+	remove_avl(&arvore, 7);
+	remove_avl(&arvore, (*minimo_avl(&arvore))->dado);
+	imprime_ordenado_avl(&arvore);
+	printf("\nAltura da arvore: %d\n", altura_avl(&arvore));
+	printf("Valores menores que 11: %d\n", posto(&arvore, 11));
+	printf("Terceiro menor valor: %d\n", seleciona(&arvore, 2)->dado);
+	printf("Valores em [4, 12]: %d\n", conta_intervalo(&arvore, 4, 12));
+	printf("Removendo o intervalo [5, 11]: %d valores\n", remove_intervalo(&arvore, 5, 11));
+	imprime_ordenado_avl(&arvore);
+	printf("\n");
+	desaloca_avl(&arvore);
+
+	srand(1);
+	chaves = (int *) malloc(N_CHAVES * sizeof(int));
+	consultas = (int *) malloc(N_CHAVES * sizeof(int));
+	printf("---\n%-13s %-12s %8s %8s %14s %14s\n", "Arvore", "Ordem", "N",
+				 "Altura", "Insercoes/s", "Buscas/s");
+	for (ordem = CRESCENTE; ordem <= ALEATORIA; ordem++) {
+		n = (ordem == ALEATORIA) ? N_CHAVES : N_DEGENERADO;
+		teste_desempenho(ordem, n, chaves, consultas, 0);
+		teste_desempenho(ordem, N_CHAVES, chaves, consultas, 1);
+	}
+	for (i = 1000; i <= 100000; i = i * 100) {
+		printf("---\nLotes de %d valores:\n", i);
+		teste_remocao(chaves, i);
+	}
+	printf("---\nEstatisticas de ordem, %d valores:\n", N_CHAVES);
+	teste_estatisticas(chaves, consultas);
+	printf("---\n");
+	printf("Erros: %ld\n", teste_aleatorio());
+	free(chaves);
+	free(consultas);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -oarvore_avl 22-arvore_avl.c
+	 ./arvore_avl
+*/
+
+/* Exercícios
+
+	 1) Desenhe a árvore AVL resultante da inserção de {5, 4, 6, 7, 8, 2, 3,
+	 1}, mostrando as rotações feitas a cada passo.
+
+	 2) Na inserção, depois de uma rotação, a altura da sub-árvore volta a
+	 ser a que era antes da inserção. Use isso para interromper a subida pelo
+	 caminho assim que a altura de um nó não mudar. O mesmo vale para a
+	 remoção?
+
+	 3) Escreva uma função que junta duas árvores AVL quaisquer (os valores
+	 podem se intercalar), em tempo O(k log(N/k + 1)), usando divide() e
+	 junta() como em remove_lote().
+
+	 4) Escreva uma função que retorna a mediana dos valores da árvore em
+	 O(log N). E os valores nos percentis 90 e 99?
+
+	 5) O campo altura ocupa um int inteiro, mas só precisamos saber se a
+	 diferença entre as alturas dos filhos é -1, 0 ou 1. Reescreva a árvore
+	 guardando apenas essa diferença.
+*/
@@ -0,0 +1,341 @@
+/* Árvores de busca em vetor (layout de Eytzinger)
+
+	 Na árvore binária de busca da aula sobre árvores, cada nó guarda um int
+	 e dois ponteiros, e os nós ficam espalhados pela memória, na ordem em
+	 que foram alocados. Cada passo de busca() precisa ler o nó atual para
+	 descobrir o endereço do próximo: se a árvore não cabe no cache, cada
+	 nível custa uma falta de cache inteira (~100 ns), e o processador não
+	 pode adiantar nada, porque não sabe para onde vai.
+
+	 A busca binária num vetor ordenado (aula de busca, em MC102) não tem
+	 ponteiros, mas tem o mesmo problema: os primeiros acessos (v[N/2],
+	 v[N/4] ou v[3N/4], ...) estão longe uns dos outros, e cada um cai numa
+	 linha de cache diferente.
+
+	 Quando o conjunto de chaves muda pouco, podemos "congelar" a árvore num
+	 vetor organizado como um heap (aula sobre heaps): a raiz fica na posição
+	 1, e os filhos do nó k ficam nas posições 2k e 2k+1. Esse é o layout de
+	 Eytzinger, ou layout em largura: os nós aparecem nível por nível.
+
+	   ordenado:    1  2  3  4  5  6  7
+	   Eytzinger:  [-] 4  2  6  1  3  5  7
+	                   ^  ^--^  ^--------^
+	                   |  nível 1  nível 2
+	                   raiz
+
+	 Vantagens:
+	 * não há ponteiros: o próximo índice é 2k ou 2k+1, e pode ser calculado
+	   sem desvios: k = 2*k + (t[k] < x);
+	 * os 16 descendentes do nó k quatro níveis abaixo ficam nas posições
+	   16k a 16k+15, que ocupam uma única linha de cache de 64 bytes (se o
+	   vetor está alinhado). Podemos pedir ao processador que traga essa linha
+	   antes de precisarmos dela (prefetch), e, enquanto ela chega, descemos
+	   os quatro níveis seguintes.
+
+	 Como a busca não para ao encontrar a chave (isso exigiria um desvio),
+	 ela desce até sair do vetor, e k termina indicando o caminho percorrido.
+	 O último nó em que descemos para a esquerda é o menor valor >= x: para
+	 recuperá-lo, basta descartar os bits 1 finais de k e mais um bit.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct noarvore {
+	int dado;
+	struct noarvore *f_esquerdo;
+	struct noarvore *f_direito;
+} NoArvore;
+
+/* Árvore congelada: t[1..n] no layout de Eytzinger */
+typedef struct arvorecongelada {
+	int n;
+	int *t;
+} ArvoreCongelada;
+
+/* Preenche t[k] e seus descendentes, em inordem, com os valores de
+	 ordenado[*i], ordenado[*i + 1], ... */
+void preenche_eytzinger(int ordenado[], int *i, int t[], int k, int n) {
+	if (k > n) return;
+	preenche_eytzinger(ordenado, i, t, 2 * k, n);
+	t[k] = ordenado[*i];
+	*i = *i + 1;
+	preenche_eytzinger(ordenado, i, t, 2 * k + 1, n);
+}
+
+/* Constrói a árvore congelada a partir de um vetor ordenado. O vetor é
+	 alinhado em 64 bytes para que cada grupo de 16 descendentes fique numa
+	 única linha de cache. */
+ArvoreCongelada *congela_vetor(int ordenado[], int n) {
+	ArvoreCongelada *a;
+	size_t bytes;
+	int i = 0;
+	a = (ArvoreCongelada *) malloc(sizeof(ArvoreCongelada));
+	a->n = n;
+	bytes = ((size_t) (n + 1) * sizeof(int) + 63) / 64 * 64;
+	a->t = (int *) aligned_alloc(64, bytes);
+	a->t[0] = 0; /* Não é usado */
+	preenche_eytzinger(ordenado, &i, a->t, 1, n);
+	return a;
+}
+
+/* Constrói a árvore congelada a partir de uma árvore binária de busca. O
+	 percurso em inordem usa uma pilha explícita, porque a árvore pode estar
+	 degenerada. */
+ArvoreCongelada *congela(NoArvore **arvore) {
+	ArvoreCongelada *a;
+	NoArvore **pilha, *no;
+	int *ordenado, n, topo, capacidade_pilha, capacidade;
+
+	capacidade_pilha = 64;
+	capacidade = 1024;
+	pilha = (NoArvore **) malloc(capacidade_pilha * sizeof(NoArvore *));
+	ordenado = (int *) malloc(capacidade * sizeof(int));
+	n = 0;
+	topo = 0;
+	no = *arvore;
+	while ((no != NULL) || (topo > 0)) {
+		while (no != NULL) {
+			if (topo == capacidade_pilha) {
+				capacidade_pilha = 2 * capacidade_pilha;
+				pilha = (NoArvore **) realloc(pilha, capacidade_pilha * sizeof(NoArvore *));
+			}
+			pilha[topo++] = no;
+			no = no->f_esquerdo;
+		}
+		no = pilha[--topo];
+		if (n == capacidade) {
+			capacidade = 2 * capacidade;
+			ordenado = (int *) realloc(ordenado, capacidade * sizeof(int));
+		}
+		ordenado[n++] = no->dado;
+		no = no->f_direito;
+	}
+	a = congela_vetor(ordenado, n);
+	free(pilha);
+	free(ordenado);
+	return a;
+}
+
+void desaloca_congelada(ArvoreCongelada *a) {
+	free(a->t);
+	free(a);
+}
+
+/* Retorna a posição k do menor valor >= x, ou 0 se todos são menores */
+int limite_inferior(ArvoreCongelada *a, int x) {
+	int *t = a->t;
+	unsigned long k = 1;
+	while (k <= (unsigned long) a->n) {
+		__builtin_prefetch(t + 16 * k);
+		k = 2 * k + (t[k] < x);
+	}
+	k = k >> __builtin_ffsl(~k);
+	return (int) k;
+}
+
+/* Retorna 1 se o valor existe na árvore e 0 caso contrário, como busca() */
+int busca_congelada(ArvoreCongelada *a, int x) {
+	int k = limite_inferior(a, x);
+	return (k != 0) && (a->t[k] == x);
+}
+
+/* A mesma busca, sem prefetch, para comparação */
+int busca_congelada_sem_prefetch(ArvoreCongelada *a, int x) {
+	int *t = a->t;
+	unsigned long k = 1;
+	while (k <= (unsigned long) a->n)
+		k = 2 * k + (t[k] < x);
+	k = k >> __builtin_ffsl(~k);
+	return (k != 0) && (t[k] == x);
+}
+
+/* Árvore binária de busca e busca binária das aulas anteriores, para
+	 comparação. A inserção é escrita sem recursão, como na aula sobre
+	 árvores AVL. */
+void insere_binario(NoArvore **arvore, int dado) {
+	while (*arvore != NULL) {
+		if (dado >= (*arvore)->dado) arvore = &((*arvore)->f_direito);
+		else arvore = &((*arvore)->f_esquerdo);
+	}
+	(*arvore) = (NoArvore *) malloc(sizeof(NoArvore));
+	(*arvore)->dado = dado;
+	(*arvore)->f_esquerdo = NULL;
+	(*arvore)->f_direito = NULL;
+}
+
+int busca(NoArvore **arvore, int valor) {
+	if ((*arvore) == NULL) return 0;
+	if (valor == (*arvore)->dado) return 1;
+	if (valor < (*arvore)->dado) return busca(&((*arvore)->f_esquerdo), valor);
+	return busca(&((*arvore)->f_direito), valor);
+}
+
+int busca_binaria(int vetor[], int tamanho, int chave) {
+	int min, max, med;
+	max = tamanho;
+	min = 0;
+	while (min < max) {
+		med = (max + min) / 2;
+		if (vetor[med] == chave) return med;
+		if (vetor[med] > chave) max = med;
+		else min = med + 1;
+	}
+	return -1;
+}
+
+/* Desaloca sem recursão: rotações à direita transformam a árvore numa
+	 lista pelo filho direito, que é liberada à medida que é percorrida */
+void desaloca(NoArvore **arvore) {
+	NoArvore *no = *arvore, *filho;
+	while (no != NULL) {
+		if (no->f_esquerdo == NULL) {
+			filho = no->f_direito;
+			free(no);
+			no = filho;
+		} else {
+			filho = no->f_esquerdo;
+			no->f_esquerdo = filho->f_direito;
+			filho->f_direito = no;
+			no = filho;
+		}
+	}
+	*arvore = NULL;
+}
+
+/* Teste de desempenho: as chaves são os ímpares 1, 3, ..., 2N-1, e as
+	 consultas são sorteadas entre 0 e 2N, de forma que metade delas não é
+	 encontrada. A árvore com ponteiros é construída inserindo as chaves em
+	 ordem aleatória; com 10^8 chaves ela ocuparia mais de 3 GB, e, por isso,
+	 só é testada até MAX_PONTEIROS chaves. */
+#define N_CONSULTAS 2000000
+#define MAX_PONTEIROS 10000000
+
+unsigned long long proximo_aleatorio(unsigned long long *estado) {
+	/* SplitMix64, como na simulação dos caixas */
+	unsigned long long z = (*estado += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+void teste_desempenho(int n, int consultas[]) {
+	unsigned long long estado = 2024;
+	ArvoreCongelada *congelada;
+	NoArvore *arvore = NULL;
+	struct timespec t1, t2;
+	int *ordenado, *ordem, i, j, t, esperados, encontrados[4];
+	double tempos[4];
+
+	ordenado = (int *) malloc((size_t) n * sizeof(int));
+	for (i = 0; i < n; i++) ordenado[i] = 2 * i + 1;
+	esperados = 0;
+	for (i = 0; i < N_CONSULTAS; i++) {
+		consultas[i] = (int) (proximo_aleatorio(&estado) % (2ULL * n + 1));
+		esperados += (consultas[i] % 2 == 1);
+	}
+
+	if (n <= MAX_PONTEIROS) {
+		ordem = (int *) malloc((size_t) n * sizeof(int));
+		for (i = 0; i < n; i++) ordem[i] = ordenado[i];
+		for (i = n - 1; i > 0; i--) {
+			j = (int) (proximo_aleatorio(&estado) % (i + 1));
+			t = ordem[i];
+			ordem[i] = ordem[j];
+			ordem[j] = t;
+		}
+		for (i = 0; i < n; i++) insere_binario(&arvore, ordem[i]);
+		free(ordem);
+		congelada = congela(&arvore);
+	} else {
+		congelada = congela_vetor(ordenado, n);
+	}
+
+	for (j = 0; j < 4; j++) {
+		encontrados[j] = 0;
+		tempos[j] = 0;
+		if ((j == 0) && (arvore == NULL)) continue;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (j == 0)
+			for (i = 0; i < N_CONSULTAS; i++) encontrados[j] += busca(&arvore, consultas[i]);
+		else if (j == 1)
+			for (i = 0; i < N_CONSULTAS; i++)
+				encontrados[j] += (busca_binaria(ordenado, n, consultas[i]) >= 0);
+		else if (j == 2)
+			for (i = 0; i < N_CONSULTAS; i++)
+				encontrados[j] += busca_congelada_sem_prefetch(congelada, consultas[i]);
+		else
+			for (i = 0; i < N_CONSULTAS; i++) encontrados[j] += busca_congelada(congelada, consultas[i]);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		tempos[j] = segundos(&t1, &t2);
+	}
+	printf("%10d", n);
+	for (j = 0; j < 4; j++) {
+		if ((j == 0) && (arvore == NULL)) printf(" %12s", "-");
+		else printf(" %12.1f", 1e9 * tempos[j] / N_CONSULTAS);
+		if (((j > 0) || (arvore != NULL)) && (encontrados[j] != esperados))
+			printf(" ERRO");
+	}
+	printf("\n");
+
+	desaloca(&arvore);
+	desaloca_congelada(congelada);
+	free(ordenado);
+}
+
+int main() {
+	int vetor[10] = {5, 2, 7, 3, 4, 17, 6, 12, 11, 10};
+	int tamanhos[] = {10000, 100000, 1000000, 10000000, 100000000};
+	ArvoreCongelada *congelada;
+	NoArvore *arvore = NULL;
+	int *consultas, i, k;
+
+	for (i = 0; i < 10; i++) insere_binario(&arvore, vetor[i]);
+	congelada = congela(&arvore);
+	printf("Layout de Eytzinger:");
+	for (i = 1; i <= congelada->n; i++) printf(" %d", congelada->t[i]);
+	printf("\n");
+	for (i = 0; i <= 18; i += 3) {
+		k = limite_inferior(congelada, i);
+		if (k == 0) printf("Menor valor >= %d: nenhum\n", i);
+		else printf("Menor valor >= %d: %d (busca: %d)\n", i, congelada->t[k],
+								busca_congelada(congelada, i));
+	}
+	desaloca_congelada(congelada);
+	desaloca(&arvore);
+
+	consultas = (int *) malloc(N_CONSULTAS * sizeof(int));
+	printf("---\nNanossegundos por busca:\n");
+	printf("%10s %12s %12s %12s %12s\n", "N", "ponteiros", "binaria",
+				 "Eytzinger", "prefetch");
+	for (i = 0; i < 5; i++)
+		teste_desempenho(tamanhos[i], consultas);
+	free(consultas);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -oarvore_eytzinger 23-arvore_eytzinger.c
+	 ./arvore_eytzinger
+*/
+
+/* Exercícios
+
+	 1) Mostre que, depois do laço de limite_inferior(), descartar os bits 1
+	 finais de k e mais um bit leva ao último nó em que a busca desceu para a
+	 esquerda.
+
+	 2) No layout de van Emde Boas, a árvore de altura h é dividida numa
+	 árvore de cima, de altura h/2, e nas árvores de baixo penduradas nela,
+	 e cada uma delas é guardada, recursivamente, num trecho contíguo do
+	 vetor. Implemente esse layout e compare-o com o de Eytzinger. Em qual
+	 deles é mais fácil calcular o índice do próximo nó?
+
+	 3) Com prefetch, a busca lê 16 vezes mais memória do que precisa nos
+	 últimos níveis. Meça o efeito de buscar 8 ou 32 descendentes adiante.
+*/
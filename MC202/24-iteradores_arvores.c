@@ -0,0 +1,429 @@
+/* Iteradores para percursos em árvores
+
+	 As funções de percurso da aula sobre árvores (imprime_ordenado(),
+	 imprime_preordem(), imprime_posordem()) têm dois problemas:
+	 * são recursivas: numa árvore degenerada, com altura N, elas fazem N
+	   chamadas aninhadas, e a pilha de chamadas (em geral, 8 MB) acaba;
+	 * imprimem os dados na tela: quem quiser usar os dados em outra parte do
+	   programa precisaria ler o texto de volta.
+
+	 Na aula sobre eliminação de recursão, resolvemos o primeiro problema com
+	 uma pilha explícita e uma função de visita chamada para cada nó. Aqui,
+	 invertemos o controle: em vez de o percurso chamar uma função para cada
+	 nó, quem usa o percurso pede os próximos dados quando quiser. O estado do
+	 percurso fica guardado num iterador:
+
+	   IteradorArvore it;
+	   int saida[256], n;
+	   inicia_iterador(&it, raiz, INORDEM);
+	   while ((n = proximos(&it, saida, 256)) > 0)
+	     ... usa saida[0..n-1] ...
+	   desaloca_iterador(&it);
+
+	 Os dados são entregues em lotes, para que o custo de chamar proximos()
+	 seja dividido entre vários nós, e o laço que usa os dados seja um laço
+	 simples sobre um vetor.
+
+	 Para cada ordem, o iterador guarda:
+	 * inordem: a pilha dos nós cujo filho esquerdo está sendo percorrido;
+	 * pré-ordem: a pilha dos nós que ainda serão visitados;
+	 * pós-ordem: a pilha dos nós cujos filhos estão sendo percorridos e o
+	   último nó visitado, para saber se voltamos do filho direito;
+	 * em largura (nível por nível): a fila dos nós que ainda serão
+	   visitados, como na busca em largura em grafos.
+
+	 A pilha tem, no máximo, h nós, e a fila, no máximo, a largura da árvore.
+	 Há também um iterador em inordem que usa memória O(1): o percurso de
+	 Morris, que modifica a árvore temporariamente.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct noarvore {
+	int dado;
+	struct noarvore *f_esquerdo;
+	struct noarvore *f_direito;
+} NoArvore;
+
+enum { INORDEM, PREORDEM, POSORDEM, NIVEL };
+
+typedef struct iteradorarvore {
+	int ordem;
+	NoArvore **nos; /* Pilha ou fila */
+	int capacidade;
+	int inicio; /* Início da fila */
+	int final; /* Topo da pilha ou final da fila */
+	NoArvore *atual; /* Inordem e pós-ordem: próximo nó a descer */
+	NoArvore *ultimo; /* Pós-ordem: último nó visitado */
+} IteradorArvore;
+
+#define CAPACIDADE_INICIAL 64
+
+void guarda_no(IteradorArvore *it, NoArvore *no) {
+	if (it->final == it->capacidade) {
+		if (it->inicio > 0) {
+			/* Fila: reaproveita o espaço do início */
+			memmove(it->nos, &(it->nos[it->inicio]),
+							(it->final - it->inicio) * sizeof(NoArvore *));
+			it->final = it->final - it->inicio;
+			it->inicio = 0;
+		}
+		if (it->final > it->capacidade / 2) {
+			it->capacidade = 2 * it->capacidade;
+			it->nos = (NoArvore **) realloc(it->nos, it->capacidade * sizeof(NoArvore *));
+		}
+	}
+	it->nos[it->final] = no;
+	it->final = it->final + 1;
+}
+
+void inicia_iterador(IteradorArvore *it, NoArvore *raiz, int ordem) {
+	it->ordem = ordem;
+	it->capacidade = CAPACIDADE_INICIAL;
+	it->nos = (NoArvore **) malloc(CAPACIDADE_INICIAL * sizeof(NoArvore *));
+	it->inicio = 0;
+	it->final = 0;
+	it->atual = NULL;
+	it->ultimo = NULL;
+	if (raiz == NULL) return;
+	if ((ordem == INORDEM) || (ordem == POSORDEM)) it->atual = raiz;
+	else guarda_no(it, raiz);
+}
+
+void desaloca_iterador(IteradorArvore *it) {
+	free(it->nos);
+}
+
+/* Escreve até max dados em saida[] e retorna quantos foram escritos; 0
+	 indica que o percurso terminou */
+int proximos(IteradorArvore *it, int saida[], int max) {
+	NoArvore *no;
+	int n = 0;
+
+	if (it->ordem == INORDEM) {
+		while (n < max) {
+			while (it->atual != NULL) {
+				guarda_no(it, it->atual);
+				it->atual = it->atual->f_esquerdo;
+			}
+			if (it->final == 0) break;
+			no = it->nos[--it->final];
+			saida[n++] = no->dado;
+			it->atual = no->f_direito;
+		}
+	} else if (it->ordem == PREORDEM) {
+		while ((n < max) && (it->final > 0)) {
+			no = it->nos[--it->final];
+			saida[n++] = no->dado;
+			if (no->f_direito != NULL) guarda_no(it, no->f_direito);
+			if (no->f_esquerdo != NULL) guarda_no(it, no->f_esquerdo);
+		}
+	} else if (it->ordem == POSORDEM) {
+		while (n < max) {
+			while (it->atual != NULL) {
+				guarda_no(it, it->atual);
+				it->atual = it->atual->f_esquerdo;
+			}
+			if (it->final == 0) break;
+			no = it->nos[it->final - 1];
+			if ((no->f_direito != NULL) && (no->f_direito != it->ultimo)) {
+				/* Ainda falta percorrer o filho direito */
+				it->atual = no->f_direito;
+			} else {
+				it->final--;
+				saida[n++] = no->dado;
+				it->ultimo = no;
+			}
+		}
+	} else {
+		while ((n < max) && (it->inicio < it->final)) {
+			no = it->nos[it->inicio++];
+			saida[n++] = no->dado;
+			if (no->f_esquerdo != NULL) guarda_no(it, no->f_esquerdo);
+			if (no->f_direito != NULL) guarda_no(it, no->f_direito);
+		}
+	}
+	return n;
+}
+
+/* Percurso de Morris
+
+	 Num percurso em inordem, depois de terminar a sub-árvore esquerda de um
+	 nó, precisamos voltar para ele; é para isso que serve a pilha. Mas o
+	 último nó visitado na sub-árvore esquerda (o predecessor do nó, que é o
+	 nó mais à direita dela) tem f_direito == NULL. O percurso de Morris usa
+	 esse ponteiro vago para guardar o caminho de volta:
+	 * antes de descer para a esquerda, faz f_direito do predecessor apontar
+	   para o nó atual (uma "costura");
+	 * ao chegar de novo ao nó, seguindo a costura, desfaz a costura, visita o
+	   nó e segue para a direita.
+
+	 Cada aresta é percorrida no máximo três vezes, e o percurso é O(N), sem
+	 memória extra. Enquanto o percurso não termina, porém, a árvore está
+	 modificada: ela não pode ser usada por outra parte do programa, e, se o
+	 percurso for abandonado no meio, encerra_morris() precisa ser chamada
+	 para desfazer as costuras. */
+typedef struct iteradormorris {
+	NoArvore *atual;
+} IteradorMorris;
+
+void inicia_morris(IteradorMorris *it, NoArvore *raiz) {
+	it->atual = raiz;
+}
+
+int proximos_morris(IteradorMorris *it, int saida[], int max) {
+	NoArvore *atual = it->atual, *predecessor;
+	int n = 0;
+	while ((atual != NULL) && (n < max)) {
+		if (atual->f_esquerdo == NULL) {
+			saida[n++] = atual->dado;
+			atual = atual->f_direito;
+			continue;
+		}
+		predecessor = atual->f_esquerdo;
+		while ((predecessor->f_direito != NULL) && (predecessor->f_direito != atual))
+			predecessor = predecessor->f_direito;
+		if (predecessor->f_direito == NULL) {
+			predecessor->f_direito = atual; /* Costura */
+			atual = atual->f_esquerdo;
+		} else {
+			predecessor->f_direito = NULL; /* Desfaz a costura */
+			saida[n++] = atual->dado;
+			atual = atual->f_direito;
+		}
+	}
+	it->atual = atual;
+	return n;
+}
+
+void encerra_morris(IteradorMorris *it) {
+	int descarte[64];
+	while (proximos_morris(it, descarte, 64) > 0);
+}
+
+/* Altura sem recursão: percurso em largura, contando os níveis */
+int altura_iterativa(NoArvore *raiz) {
+	IteradorArvore it;
+	NoArvore *no;
+	int altura = 0, fim_do_nivel;
+	inicia_iterador(&it, raiz, NIVEL);
+	while (it.inicio < it.final) {
+		altura++;
+		fim_do_nivel = it.final - it.inicio;
+		while (fim_do_nivel-- > 0) {
+			no = it.nos[it.inicio++];
+			if (no->f_esquerdo != NULL) guarda_no(&it, no->f_esquerdo);
+			if (no->f_direito != NULL) guarda_no(&it, no->f_direito);
+		}
+	}
+	desaloca_iterador(&it);
+	return altura;
+}
+
+/* Desalocação sem recursão e sem memória extra: rotações à direita
+	 transformam a árvore numa lista pelo filho direito, que é liberada à
+	 medida que é percorrida */
+void desaloca_iterativa(NoArvore **arvore) {
+	NoArvore *no = *arvore, *filho;
+	while (no != NULL) {
+		if (no->f_esquerdo == NULL) {
+			filho = no->f_direito;
+			free(no);
+			no = filho;
+		} else {
+			filho = no->f_esquerdo;
+			no->f_esquerdo = filho->f_direito;
+			filho->f_direito = no;
+			no = filho;
+		}
+	}
+	*arvore = NULL;
+}
+
+/* Inserção sem recursão, como na aula sobre árvores AVL, e percursos
+	 recursivos da aula sobre árvores, com uma função de visita no lugar de
+	 printf() */
+void insere_binario(NoArvore **arvore, int dado) {
+	while (*arvore != NULL) {
+		if (dado >= (*arvore)->dado) arvore = &((*arvore)->f_direito);
+		else arvore = &((*arvore)->f_esquerdo);
+	}
+	(*arvore) = (NoArvore *) malloc(sizeof(NoArvore));
+	(*arvore)->dado = dado;
+	(*arvore)->f_esquerdo = NULL;
+	(*arvore)->f_direito = NULL;
+}
+
+/* Árvore degenerada com os valores 1, ..., n: cada nó é filho esquerdo do
+	 seguinte. É a árvore que insere_binario() produz com os valores em ordem
+	 decrescente, mas construída em O(n). */
+NoArvore *constroi_cadeia(int n) {
+	NoArvore *raiz = NULL, *no;
+	int i;
+	for (i = 1; i <= n; i++) {
+		no = (NoArvore *) malloc(sizeof(NoArvore));
+		no->dado = i;
+		no->f_esquerdo = raiz;
+		no->f_direito = NULL;
+		raiz = no;
+	}
+	return raiz;
+}
+
+typedef void (*FuncaoVisita)(int dado, void *contexto);
+
+void percorre_recursivo(NoArvore *no, int ordem, FuncaoVisita visita, void *contexto) {
+	if (no == NULL) return;
+	if (ordem == PREORDEM) visita(no->dado, contexto);
+	percorre_recursivo(no->f_esquerdo, ordem, visita, contexto);
+	if (ordem == INORDEM) visita(no->dado, contexto);
+	percorre_recursivo(no->f_direito, ordem, visita, contexto);
+	if (ordem == POSORDEM) visita(no->dado, contexto);
+}
+
+void mistura_visita(int dado, void *contexto) {
+	*((unsigned long long *) contexto) = *((unsigned long long *) contexto) * 31 + dado;
+}
+
+unsigned long long mistura_lote(unsigned long long h, int saida[], int n) {
+	int i;
+	for (i = 0; i < n; i++) h = h * 31 + saida[i];
+	return h;
+}
+
+double segundos(struct timespec *t1, struct timespec *t2) {
+	return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1e9;
+}
+
+/* Teste de desempenho: percorre uma árvore de N_NOS nós, construída
+	 inserindo valores em ordem aleatória, e uma árvore degenerada (uma
+	 cadeia de filhos esquerdos) de N_DEGENERADA nós, na qual a versão
+	 recursiva estouraria a pilha de chamadas e por isso não é executada. */
+#define N_NOS 2000000
+#define N_DEGENERADA 1000000
+#define TAMANHO_LOTE 256
+
+const char *nomes_ordens[] = {"inordem", "pre-ordem", "pos-ordem", "em largura"};
+
+void teste_desempenho(NoArvore *raiz, int n, int recursivo) {
+	IteradorArvore it;
+	IteradorMorris morris;
+	struct timespec t1, t2;
+	unsigned long long h_recursivo, h_iterador;
+	int saida[TAMANHO_LOTE], k, ordem, contados;
+
+	for (ordem = INORDEM; ordem <= NIVEL; ordem++) {
+		printf("%-11s", nomes_ordens[ordem]);
+		h_recursivo = 0;
+		if (recursivo && (ordem != NIVEL)) {
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			percorre_recursivo(raiz, ordem, mistura_visita, &h_recursivo);
+			clock_gettime(CLOCK_MONOTONIC, &t2);
+			printf(" recursivo %e/s", n / segundos(&t1, &t2));
+		}
+		h_iterador = 0;
+		contados = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		inicia_iterador(&it, raiz, ordem);
+		while ((k = proximos(&it, saida, TAMANHO_LOTE)) > 0) {
+			h_iterador = mistura_lote(h_iterador, saida, k);
+			contados += k;
+		}
+		desaloca_iterador(&it);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		printf(" iterador %e/s", n / segundos(&t1, &t2));
+		if ((contados != n) || (recursivo && (ordem != NIVEL) && (h_iterador != h_recursivo)))
+			printf(" ERRO");
+		if (ordem == INORDEM) {
+			h_recursivo = h_iterador;
+			h_iterador = 0;
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			inicia_morris(&morris, raiz);
+			while ((k = proximos_morris(&morris, saida, TAMANHO_LOTE)) > 0)
+				h_iterador = mistura_lote(h_iterador, saida, k);
+			clock_gettime(CLOCK_MONOTONIC, &t2);
+			printf(" Morris %e/s%s", n / segundos(&t1, &t2),
+						 (h_iterador == h_recursivo) ? "" : " ERRO");
+		}
+		printf("\n");
+	}
+}
+
+int main() {
+	int vetor[10] = {5, 2, 7, 3, 4, 17, 6, 12, 11, 10};
+	NoArvore *arvore = NULL;
+	IteradorArvore it;
+	IteradorMorris morris;
+	int saida[4], i, k, ordem, *valores, t;
+
+	for (i = 0; i < 10; i++) insere_binario(&arvore, vetor[i]);
+	/* Lotes de 4, para mostrar que o percurso continua de onde parou */
+	for (ordem = INORDEM; ordem <= NIVEL; ordem++) {
+		printf("%-11s:", nomes_ordens[ordem]);
+		inicia_iterador(&it, arvore, ordem);
+		while ((k = proximos(&it, saida, 4)) > 0) {
+			printf(" [");
+			for (i = 0; i < k; i++) printf(i ? " %d" : "%d", saida[i]);
+			printf("]");
+		}
+		desaloca_iterador(&it);
+		printf("\n");
+	}
+	printf("Morris, 4 primeiros e encerrado:");
+	inicia_morris(&morris, arvore);
+	k = proximos_morris(&morris, saida, 4);
+	for (i = 0; i < k; i++) printf(" %d", saida[i]);
+	encerra_morris(&morris);
+	printf("\nAltura: %d\n", altura_iterativa(arvore));
+	printf("inordem depois de encerrar:");
+	inicia_iterador(&it, arvore, INORDEM);
+	while ((k = proximos(&it, saida, 4)) > 0)
+		for (i = 0; i < k; i++) printf(" %d", saida[i]);
+	desaloca_iterador(&it);
+	printf("\n");
+	desaloca_iterativa(&arvore);
+
+	printf("---\nArvore aleatoria, %d nos, dados por segundo:\n", N_NOS);
+	srand(1);
+	valores = (int *) malloc(N_NOS * sizeof(int));
+	for (i = 0; i < N_NOS; i++) valores[i] = i;
+	for (i = N_NOS - 1; i > 0; i--) {
+		k = (int) ((((unsigned long) rand() << 15) ^ (unsigned long) rand()) % (i + 1));
+		t = valores[i];
+		valores[i] = valores[k];
+		valores[k] = t;
+	}
+	for (i = 0; i < N_NOS; i++) insere_binario(&arvore, valores[i]);
+	free(valores);
+	printf("Altura: %d\n", altura_iterativa(arvore));
+	teste_desempenho(arvore, N_NOS, 1);
+	desaloca_iterativa(&arvore);
+
+	printf("---\nArvore degenerada, %d nos, dados por segundo:\n", N_DEGENERADA);
+	arvore = constroi_cadeia(N_DEGENERADA);
+	printf("Altura: %d\n", altura_iterativa(arvore));
+	teste_desempenho(arvore, N_DEGENERADA, 0);
+	desaloca_iterativa(&arvore);
+	return 0;
+}
+
+/* Para executar:
+	 gcc -O2 -oiteradores_arvores 24-iteradores_arvores.c
+	 ./iteradores_arvores
+*/
+
+/* Exercícios
+
+	 1) Escreva um iterador em pré-ordem pelo método de Morris.
+
+	 2) Escreva um iterador que começa no menor valor >= x, em vez de
+	 começar no mínimo da árvore. Quantos nós ele precisa empilhar?
+
+	 3) Se cada nó guardasse um ponteiro para o pai, o iterador em inordem
+	 não precisaria de pilha. Escreva a função que encontra o sucessor de um
+	 nó usando esse ponteiro. Qual é o custo de mantê-lo na inserção e na
+	 remoção?
+*/